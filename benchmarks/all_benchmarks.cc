@@ -0,0 +1,47 @@
+#include <iostream>
+#include <string>
+
+#include "benchmark_encode.h"
+#include "benchmark_fake_game.h"
+#include "benchmark_geometry.h"
+#include "benchmark_loopback.h"
+#include "benchmark_observation.h"
+#include "benchmark_response_arena.h"
+#include "benchmark_spatial_index.h"
+#include "benchmark_tag_map.h"
+#include "benchmark_unit_columns.h"
+#include "benchmark_unit_types.h"
+
+// Benchmarks run offline on synthetic or recorded data, a running StarCraft II is not required.
+#define BENCHMARK(X)                                                    \
+    std::cout << "Running benchmark: " << #X << std::endl;              \
+    if (X(argc, argv)) {                                                \
+        std::cout << "Benchmark: " << #X << " succeeded." << std::endl; \
+    } else {                                                            \
+        success = false;                                                \
+        std::cerr << "Benchmark: " << #X << " failed!" << std::endl;    \
+    }
+
+//*************************************************************************************************
+int main(int argc, char* argv[]) {
+    bool success = true;
+
+    // Add benchmarks here.
+    BENCHMARK(sc2::BenchmarkSpatialIndex);
+    BENCHMARK(sc2::BenchmarkUnitColumns);
+    BENCHMARK(sc2::BenchmarkGeometry);
+    BENCHMARK(sc2::BenchmarkTagMap);
+    BENCHMARK(sc2::BenchmarkUnitTypes);
+    BENCHMARK(sc2::BenchmarkEncode);
+    BENCHMARK(sc2::BenchmarkResponseArena);
+    BENCHMARK(sc2::BenchmarkObservation);
+    BENCHMARK(sc2::BenchmarkFakeGame);
+    BENCHMARK(sc2::BenchmarkLoopback);
+
+    if (success)
+        std::cout << "All benchmarks succeeded!" << std::endl;
+    else
+        std::cerr << "Some benchmarks failed!" << std::endl;
+
+    return success ? 0 : -1;
+}
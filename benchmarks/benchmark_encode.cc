@@ -0,0 +1,121 @@
+#include "benchmark_encode.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "s2clientprotocol/sc2api.pb.h"
+#include "sc2api/sc2_connection.h"
+
+using namespace std::chrono;
+
+namespace sc2 {
+
+namespace {
+
+const int kIterations = 20000;
+
+struct EncodeCase {
+    std::string name;
+    SC2APIProtocol::Request request;
+};
+
+std::vector<EncodeCase> CreateRequests() {
+    std::vector<EncodeCase> cases(4);
+
+    cases[0].name = "Step";
+    cases[0].request.mutable_step()->set_count(1);
+
+    cases[1].name = "Observation";
+    cases[1].request.mutable_observation();
+
+    // A busy step of a bot commanding its army.
+    cases[2].name = "Action (100 commands)";
+    SC2APIProtocol::RequestAction* request_action = cases[2].request.mutable_action();
+    for (int i = 0; i < 100; ++i) {
+        SC2APIProtocol::ActionRawUnitCommand* command =
+            request_action->add_actions()->mutable_action_raw()->mutable_unit_command();
+        command->set_ability_id(23);
+        command->mutable_target_world_space_pos()->set_x(static_cast<float>(i));
+        command->mutable_target_world_space_pos()->set_y(static_cast<float>(i));
+        for (int tag = 0; tag < 8; ++tag) {
+            command->add_unit_tags(4294967297ULL + i * 8 + tag);
+        }
+    }
+
+    cases[3].name = "Debug (200 lines)";
+    SC2APIProtocol::DebugDraw* draw = cases[3].request.mutable_debug()->add_debug()->mutable_draw();
+    for (int i = 0; i < 200; ++i) {
+        SC2APIProtocol::DebugLine* line = draw->add_lines();
+        line->mutable_color()->set_r(255);
+        line->mutable_line()->mutable_p0()->set_x(static_cast<float>(i));
+        line->mutable_line()->mutable_p1()->set_y(static_cast<float>(i));
+    }
+
+    return cases;
+}
+
+// The way requests used to be sent: a fresh buffer for every request and the size computed twice.
+double TimeAllocatingEncode(const SC2APIProtocol::Request& request, size_t& bytes) {
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        size_t size = request.ByteSizeLong();
+        void* buffer = malloc(size);
+        request.SerializeToArray(buffer, (int)size);
+        bytes += size + static_cast<unsigned char*>(buffer)[size / 2];
+        free(buffer);
+    }
+    return duration_cast<duration<double>>(high_resolution_clock::now() - start).count();
+}
+
+double TimeBufferedEncode(const SC2APIProtocol::Request& request, size_t& bytes) {
+    std::vector<char> buffer;
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        size_t size = SerializeToBuffer(request, buffer);
+        bytes += size + static_cast<unsigned char>(buffer[size / 2]);
+    }
+    return duration_cast<duration<double>>(high_resolution_clock::now() - start).count();
+}
+
+}  // namespace
+
+bool BenchmarkEncode(int, char**) {
+    std::vector<EncodeCase> cases = CreateRequests();
+
+    std::cout << std::endl;
+    std::cout << "Request encoding (ns per request)" << std::endl;
+    std::cout << "---------------------------------------------------------------" << std::endl;
+    std::cout << "|" << std::setw(24) << std::left << "Request" << std::right << "|" << std::setw(8) << std::left
+              << "Bytes" << std::right << "|" << std::setw(14) << std::left << "Allocating" << std::right << "|"
+              << std::setw(12) << std::left << "Reused" << std::right << "|" << std::endl;
+
+    // Accumulated so the encoding can't be optimized away.
+    size_t bytes = 0;
+    bool success = true;
+    std::vector<char> buffer;
+    for (const EncodeCase& encode_case : cases) {
+        const size_t size = SerializeToBuffer(encode_case.request, buffer);
+        if (std::string(buffer.data(), size) != encode_case.request.SerializeAsString()) {
+            std::cerr << "Encoded " << encode_case.name << " request differs from SerializeAsString." << std::endl;
+            success = false;
+        }
+
+        const double allocating = TimeAllocatingEncode(encode_case.request, bytes);
+        const double reused = TimeBufferedEncode(encode_case.request, bytes);
+
+        std::cout << "|" << std::setw(24) << std::left << encode_case.name << std::right << "|" << std::setw(8)
+                  << std::left << encode_case.request.ByteSizeLong() << std::right << "|" << std::setw(14)
+                  << std::left << allocating * 1e9 / kIterations << std::right << "|" << std::setw(12) << std::left
+                  << reused * 1e9 / kIterations << std::right << "|" << std::endl;
+    }
+    std::cout << "---------------------------------------------------------------" << std::endl;
+    std::cout << std::endl;
+
+    return success && bytes > 0;
+}
+
+}  // namespace sc2
@@ -0,0 +1,7 @@
+#pragma once
+
+namespace sc2 {
+
+bool BenchmarkEncode(int argc, char** argv);
+
+}
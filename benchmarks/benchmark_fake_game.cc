@@ -0,0 +1,195 @@
+#include "benchmark_fake_game.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "sc2api/sc2_api.h"
+#include "sc2fakeserver/sc2_fake_game_server.h"
+
+using namespace std::chrono;
+
+namespace sc2 {
+
+namespace {
+
+const int kSteps = 1000;
+const int kFirstPort = 5780;
+const int kPollPort = kFirstPort + 10;
+const int kPollLatencyUs = 20000;
+
+// Moves one of its units every step so actions go through the whole stack as well.
+class StepBot : public Agent {
+public:
+    void OnStep() final {
+        const Units units = Observation()->GetUnits(Unit::Alliance::Self);
+        if (!units.empty()) {
+            const Unit* unit = units[Observation()->GetGameLoop() % units.size()];
+            Actions()->UnitCommand(unit, ABILITY_ID::MOVE_MOVE, unit->pos + Point2D(1.0F, 1.0F));
+        }
+    }
+};
+
+struct StepRateStats {
+    int own_units;
+    bool tuned;
+    double steps_per_second;
+    double requests_per_step;
+};
+
+bool RunStepRate(int own_units, bool tuned, int port, StepRateStats& stats) {
+    FakeGameSettings settings;
+    settings.own_units = own_units;
+    settings.enemy_units = own_units / 2;
+    FakeGameServer server(settings);
+    if (!server.Start(port)) {
+        std::cerr << "Failed to serve the fake game on port " << port << std::endl;
+        return false;
+    }
+
+    StepBot bot;
+    Coordinator coordinator;
+    coordinator.SetParticipants({CreateParticipant(Race::Terran, &bot)});
+    coordinator.SetResponseArenas(tuned);
+    coordinator.SetPipelining(tuned);
+    coordinator.Connect(port);
+    if (!coordinator.StartGame("Synthetic.SC2Map")) {
+        return false;
+    }
+
+    const uint64_t requests_before = server.GetRequestCount();
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+    bool success = true;
+    for (int i = 0; i < kSteps && success; ++i) {
+        success = coordinator.Update();
+    }
+    const double elapsed = duration_cast<duration<double>>(high_resolution_clock::now() - start).count();
+
+    stats.own_units = own_units;
+    stats.tuned = tuned;
+    stats.steps_per_second = kSteps / elapsed;
+    stats.requests_per_step = static_cast<double>(server.GetRequestCount() - requests_before) / kSteps;
+
+    if (!success || bot.Observation()->GetGameLoop() < static_cast<uint32_t>(kSteps)) {
+        std::cerr << "Stepping the fake game with " << own_units << " units failed." << std::endl;
+        return false;
+    }
+
+    // Pipelined action acknowledgments may still be in flight between steps, they must not count as a pending response
+    // nor cause errors once consumed.
+    if (bot.Control()->HasResponsePending() || !bot.Control()->GetClientErrors().empty()) {
+        std::cerr << "Stepping the fake game with " << own_units << " units left a response pending or errors."
+                  << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// The game answers requests in order, so the acknowledgment of a pipelined action arrives a full latency ahead of the
+// response sent after it. Polling in between must consume the acknowledgment without reporting the response as ready.
+bool CheckPipelinedPoll(int port) {
+    FakeGameSettings settings;
+    settings.latency_us = kPollLatencyUs;
+    FakeGameServer server(settings);
+    if (!server.Start(port)) {
+        std::cerr << "Failed to serve the fake game on port " << port << std::endl;
+        return false;
+    }
+
+    StepBot bot;
+    Coordinator coordinator;
+    coordinator.SetParticipants({CreateParticipant(Race::Terran, &bot)});
+    coordinator.SetPipelining(true);
+    coordinator.Connect(port);
+    if (!coordinator.StartGame("Synthetic.SC2Map")) {
+        return false;
+    }
+
+    ControlInterface* control = bot.Control();
+    ProtoInterface& proto = control->Proto();
+    const Units units = bot.Observation()->GetUnits(Unit::Alliance::Self);
+    if (units.empty()) {
+        std::cerr << "The fake game has no units to move." << std::endl;
+        return false;
+    }
+
+    GameRequestPtr action_request = proto.MakeRequest();
+    SC2APIProtocol::ActionRawUnitCommand* command =
+        action_request->mutable_action()->add_actions()->mutable_action_raw()->mutable_unit_command();
+    command->set_ability_id(static_cast<int>(ABILITY_ID::MOVE_MOVE));
+    command->add_unit_tags(units.front()->tag);
+    command->mutable_target_world_space_pos()->set_x(units.front()->pos.x + 1.0F);
+    command->mutable_target_world_space_pos()->set_y(units.front()->pos.y + 1.0F);
+    GameRequestPtr observation_request = proto.MakeRequest();
+    observation_request->mutable_observation();
+    if (!proto.SendRequest(action_request, false, false) || !proto.SendRequest(observation_request)) {
+        std::cerr << "Sending the pipelined requests failed." << std::endl;
+        return false;
+    }
+
+    // Halfway between the two answers only the acknowledgment has arrived.
+    std::this_thread::sleep_for(microseconds(kPollLatencyUs * 3 / 2));
+    if (proto.PollResponse() || proto.GetPendingResponseCount() != 1) {
+        std::cerr << "Polling reported the response ready while only the acknowledgment had arrived." << std::endl;
+        return false;
+    }
+
+    const steady_clock::time_point deadline = steady_clock::now() + seconds(5);
+    while (!proto.PollResponse()) {
+        if (steady_clock::now() > deadline) {
+            std::cerr << "The polled response never arrived." << std::endl;
+            return false;
+        }
+        std::this_thread::sleep_for(microseconds(100));
+    }
+
+    GameResponsePtr response = control->WaitForResponse();
+    if (!response.get() || !response->has_observation() || control->HasResponsePending() ||
+        !control->GetClientErrors().empty()) {
+        std::cerr << "The polled response wasn't the observation or left errors." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+}  // namespace
+
+bool BenchmarkFakeGame(int, char**) {
+    static const int unit_counts[] = {50, 350, 1000};
+
+    bool success = true;
+    int port = kFirstPort;
+    std::vector<StepRateStats> results;
+    for (int own_units : unit_counts) {
+        for (bool tuned : {false, true}) {
+            StepRateStats stats = StepRateStats();
+            success = RunStepRate(own_units, tuned, port++, stats) && success;
+            results.push_back(stats);
+        }
+    }
+
+    success = CheckPipelinedPoll(kPollPort) && success;
+
+    std::cout << std::endl;
+    std::cout << "Agent stepping a fake game server, " << kSteps << " steps" << std::endl;
+    std::cout << "---------------------------------------------------------" << std::endl;
+    std::cout << "|" << std::setw(8) << std::left << "Units" << std::right << "|" << std::setw(19) << std::left
+              << "Arenas+pipelining" << std::right << "|" << std::setw(10) << std::left << "Steps/s" << std::right
+              << "|" << std::setw(15) << std::left << "Requests/step" << std::right << "|" << std::endl;
+    for (const StepRateStats& stats : results) {
+        std::cout << "|" << std::setw(8) << std::left << stats.own_units << std::right << "|" << std::setw(19)
+                  << std::left << (stats.tuned ? "on" : "off") << std::right << "|" << std::setw(10) << std::left
+                  << stats.steps_per_second << std::right << "|" << std::setw(15) << std::left
+                  << stats.requests_per_step << std::right << "|" << std::endl;
+    }
+    std::cout << "---------------------------------------------------------" << std::endl;
+    std::cout << std::endl;
+
+    return success;
+}
+
+}  // namespace sc2
@@ -0,0 +1,192 @@
+#include "benchmark_geometry.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "sc2api/sc2_common.h"
+
+using namespace std::chrono;
+
+namespace sc2 {
+
+namespace {
+
+const size_t kPointCount = 10000;
+const size_t kMatrixSize = 300;
+const float kRadius = 20.0F;
+const int kIterations = 200;
+
+struct GeometryStats {
+    const char* name;
+    double distances;
+    double closest;
+    double in_radius;
+    double matrix;
+    double centroid;
+};
+
+double ElapsedMicroseconds(high_resolution_clock::time_point start) {
+    return duration_cast<duration<double>>(high_resolution_clock::now() - start).count() * 1e6 / kIterations;
+}
+
+// The single point functions called in loops, as user code does without the batch functions.
+GeometryStats RunLoops(const std::vector<Point2D>& points, const Point2D& center, size_t& checksum) {
+    GeometryStats stats = {"Loop", 0.0, 0.0, 0.0, 0.0, 0.0};
+    std::vector<float> distances(points.size());
+    std::vector<float> matrix(kMatrixSize * kMatrixSize);
+
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        for (size_t j = 0; j < points.size(); ++j) {
+            distances[j] = Distance2D(center, points[j]);
+        }
+    }
+    stats.distances = ElapsedMicroseconds(start);
+
+    start = high_resolution_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        size_t closest = points.size();
+        float closest_distance = std::numeric_limits<float>::infinity();
+        for (size_t j = 0; j < points.size(); ++j) {
+            const float distance = DistanceSquared2D(center, points[j]);
+            if (distance < closest_distance) {
+                closest_distance = distance;
+                closest = j;
+            }
+        }
+        checksum += closest;
+    }
+    stats.closest = ElapsedMicroseconds(start);
+
+    start = high_resolution_clock::now();
+    std::vector<size_t> indices;
+    for (int i = 0; i < kIterations; ++i) {
+        indices.clear();
+        for (size_t j = 0; j < points.size(); ++j) {
+            if (DistanceSquared2D(center, points[j]) <= kRadius * kRadius) {
+                indices.push_back(j);
+            }
+        }
+        checksum += indices.size();
+    }
+    stats.in_radius = ElapsedMicroseconds(start);
+
+    start = high_resolution_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        for (size_t a = 0; a < kMatrixSize; ++a) {
+            for (size_t b = 0; b < kMatrixSize; ++b) {
+                matrix[a * kMatrixSize + b] = Distance2D(points[a], points[b]);
+            }
+        }
+    }
+    stats.matrix = ElapsedMicroseconds(start);
+
+    start = high_resolution_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        Point2D sum;
+        for (const Point2D& point : points) {
+            sum += point;
+        }
+        checksum += static_cast<size_t>(sum.x / points.size());
+    }
+    stats.centroid = ElapsedMicroseconds(start);
+
+    checksum += static_cast<size_t>(distances.back() + matrix.back());
+    return stats;
+}
+
+GeometryStats RunBatch(const char* name, const std::vector<Point2D>& points, const Point2D& center, size_t& checksum) {
+    GeometryStats stats = {name, 0.0, 0.0, 0.0, 0.0, 0.0};
+    std::vector<float> distances(points.size());
+    std::vector<float> matrix(kMatrixSize * kMatrixSize);
+
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        Distances2D(center, points.data(), points.size(), distances.data());
+    }
+    stats.distances = ElapsedMicroseconds(start);
+
+    start = high_resolution_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        checksum += ClosestPoint2D(center, points.data(), points.size());
+    }
+    stats.closest = ElapsedMicroseconds(start);
+
+    start = high_resolution_clock::now();
+    std::vector<size_t> indices;
+    for (int i = 0; i < kIterations; ++i) {
+        indices.clear();
+        PointsInRadius2D(center, kRadius, points.data(), points.size(), indices);
+        checksum += indices.size();
+    }
+    stats.in_radius = ElapsedMicroseconds(start);
+
+    start = high_resolution_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        DistanceMatrix2D(points.data(), kMatrixSize, points.data(), kMatrixSize, matrix.data());
+    }
+    stats.matrix = ElapsedMicroseconds(start);
+
+    start = high_resolution_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        checksum += static_cast<size_t>(Centroid2D(points.data(), points.size()).x);
+    }
+    stats.centroid = ElapsedMicroseconds(start);
+
+    checksum += static_cast<size_t>(distances.back() + matrix.back());
+    return stats;
+}
+
+}  // namespace
+
+bool BenchmarkGeometry(int, char**) {
+    std::mt19937 generator(static_cast<std::mt19937::result_type>(kPointCount));
+    std::uniform_real_distribution<float> position(0.0F, 200.0F);
+    std::vector<Point2D> points;
+    for (size_t i = 0; i < kPointCount; ++i) {
+        points.emplace_back(position(generator), position(generator));
+    }
+    const Point2D center(100.0F, 100.0F);
+
+    // Keeps the results alive so that the loops aren't optimized away.
+    size_t checksum = 0;
+    std::vector<GeometryStats> results;
+    results.push_back(RunLoops(points, center, checksum));
+
+    const SimdLevel default_level = GetSimdLevel();
+    const SimdLevel levels[] = {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2};
+    const char* level_names[] = {"Scalar", "SSE2", "AVX2"};
+    for (size_t level = 0; level < 3; ++level) {
+        if (SetSimdLevel(levels[level]) == levels[level]) {
+            results.push_back(RunBatch(level_names[level], points, center, checksum));
+        }
+    }
+    SetSimdLevel(default_level);
+
+    std::cout << std::endl;
+    std::cout << "Batch geometry over " << kPointCount << " points, distance matrix of " << kMatrixSize << "x"
+              << kMatrixSize << " points (us per call), checksum " << checksum << std::endl;
+    std::cout << "----------------------------------------------------------------------" << std::endl;
+    std::cout << "|" << std::setw(8) << std::left << "Kernels" << std::right << "|" << std::setw(11) << std::left
+              << "Distances" << std::right << "|" << std::setw(11) << std::left << "Closest" << std::right << "|"
+              << std::setw(11) << std::left << "In radius" << std::right << "|" << std::setw(11) << std::left
+              << "Matrix" << std::right << "|" << std::setw(11) << std::left << "Centroid" << std::right << "|"
+              << std::endl;
+    for (const GeometryStats& stats : results) {
+        std::cout << "|" << std::setw(8) << std::left << stats.name << std::right << "|" << std::setw(11) << std::left
+                  << stats.distances << std::right << "|" << std::setw(11) << std::left << stats.closest << std::right
+                  << "|" << std::setw(11) << std::left << stats.in_radius << std::right << "|" << std::setw(11)
+                  << std::left << stats.matrix << std::right << "|" << std::setw(11) << std::left << stats.centroid
+                  << std::right << "|" << std::endl;
+    }
+    std::cout << "----------------------------------------------------------------------" << std::endl;
+    std::cout << std::endl;
+
+    return true;
+}
+
+}  // namespace sc2
@@ -0,0 +1,195 @@
+#include "benchmark_loopback.h"
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "s2clientprotocol/sc2api.pb.h"
+#include "sc2api/sc2_connection.h"
+#include "sc2api/sc2_proto_stats.h"
+#include "sc2api/sc2_server.h"
+
+using namespace std::chrono;
+
+namespace sc2 {
+
+namespace {
+
+const int kRequests = 20000;
+const int kPort = 5790;
+const unsigned int kTimeoutMs = 5000;
+
+// Answers every request with a ping as soon as it arrives, so the round trip is all client and transport.
+class PingServer {
+public:
+    bool Start(int port) {
+        const std::string listening_port = std::to_string(port);
+        if (!server_.Listen(listening_port.c_str(), "100000", "100000", "2")) {
+            return false;
+        }
+
+        running_ = true;
+        thread_ = std::thread(&PingServer::Run, this);
+        return true;
+    }
+
+    void Stop() {
+        running_ = false;
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+private:
+    void Run() {
+        SC2APIProtocol::Response response;
+        response.mutable_ping()->set_base_build(93333);
+        std::string data;
+        while (running_) {
+            if (!server_.WaitForRequest(100)) {
+                continue;
+            }
+
+            RequestData request;
+            while (server_.PopRequest(request)) {
+                response.set_id(request.second->id());
+                response.SerializeToString(&data);
+                server_.SendResponse(request.first, data.data(), data.size());
+                delete request.second;
+            }
+        }
+    }
+
+    Server server_;
+    std::thread thread_;
+    std::atomic_bool running_{false};
+};
+
+struct RoundTripStats {
+    unsigned int spin_us;
+    double mean_us;
+    double p50_us;
+    double p99_us;
+    double requests_per_second;
+};
+
+bool RunRoundTrips(Connection& connection, unsigned int spin_us, RoundTripStats& stats) {
+    connection.SetSpinWait(spin_us);
+
+    SC2APIProtocol::Request request;
+    request.mutable_ping();
+    LatencyHistogram latency_ns;
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+    for (int i = 0; i < kRequests; ++i) {
+        request.set_id(static_cast<uint32_t>(i + 1));
+        const steady_clock::time_point sent = steady_clock::now();
+        connection.Send(&request);
+
+        SC2APIProtocol::Response* response = nullptr;
+        if (!connection.Receive(response, kTimeoutMs) || !response) {
+            return false;
+        }
+        latency_ns.Record(static_cast<uint64_t>(duration_cast<nanoseconds>(steady_clock::now() - sent).count()));
+
+        const bool matched = response->has_ping() && response->id() == request.id();
+        connection.ReleaseResponse(response);
+        if (!matched) {
+            return false;
+        }
+    }
+    const double seconds = duration_cast<duration<double>>(high_resolution_clock::now() - start).count();
+
+    stats.spin_us = spin_us;
+    stats.mean_us = latency_ns.GetMean() / 1000.0;
+    stats.p50_us = latency_ns.GetPercentile(50.0) / 1000.0;
+    stats.p99_us = latency_ns.GetPercentile(99.0) / 1000.0;
+    stats.requests_per_second = kRequests / seconds;
+    return true;
+}
+
+// A client that stops consuming responses fills the queue, pushing must then fail instead of blocking the civetweb
+// thread. The responses queued before are still received.
+bool CheckFullQueue() {
+    Connection connection;
+    size_t pushed = 0;
+    for (; pushed < 4096; ++pushed) {
+        SC2APIProtocol::Response* response = new SC2APIProtocol::Response();
+        response->set_id(static_cast<uint32_t>(pushed + 1));
+        if (!connection.PushResponse(response)) {
+            if (response) {
+                return false;
+            }
+            break;
+        }
+    }
+
+    bool success = pushed > 0 && pushed < 4096;
+    for (size_t i = 0; i < pushed; ++i) {
+        SC2APIProtocol::Response* response = nullptr;
+        if (!connection.Receive(response, kTimeoutMs) || !response) {
+            return false;
+        }
+        success = response->id() == i + 1 && success;
+        connection.ReleaseResponse(response);
+    }
+
+    if (!success) {
+        std::cerr << "A full response queue didn't reject the response." << std::endl;
+    }
+
+    return success;
+}
+
+}  // namespace
+
+bool BenchmarkLoopback(int, char**) {
+    PingServer server;
+    if (!server.Start(kPort)) {
+        std::cerr << "Failed to listen on port " << kPort << std::endl;
+        return false;
+    }
+
+    Connection connection;
+    if (!connection.Connect("127.0.0.1", kPort, false)) {
+        server.Stop();
+        return false;
+    }
+
+    // Sleeping right away is the default, spinning has to be enabled.
+    RoundTripStats sleeping = RoundTripStats();
+    RoundTripStats spinning = RoundTripStats();
+    bool success = CheckFullQueue();
+    success = RunRoundTrips(connection, 0, sleeping) && success;
+    success = RunRoundTrips(connection, 50, spinning) && success;
+
+    connection.Disconnect();
+    server.Stop();
+
+    if (!success) {
+        std::cerr << "A ping went unanswered." << std::endl;
+        return false;
+    }
+
+    std::cout << std::endl;
+    std::cout << "Ping round trips against a loopback server, " << kRequests << " requests" << std::endl;
+    std::cout << "---------------------------------------------------------" << std::endl;
+    std::cout << "|" << std::setw(10) << std::left << "Spin us" << std::right << "|" << std::setw(10) << std::left
+              << "Mean us" << std::right << "|" << std::setw(10) << std::left << "p50 us" << std::right << "|"
+              << std::setw(10) << std::left << "p99 us" << std::right << "|" << std::setw(12) << std::left
+              << "Requests/s" << std::right << "|" << std::endl;
+    for (const RoundTripStats& stats : {sleeping, spinning}) {
+        std::cout << "|" << std::setw(10) << std::left << stats.spin_us << std::right << "|" << std::setw(10)
+                  << std::left << stats.mean_us << std::right << "|" << std::setw(10) << std::left << stats.p50_us
+                  << std::right << "|" << std::setw(10) << std::left << stats.p99_us << std::right << "|"
+                  << std::setw(12) << std::left << stats.requests_per_second << std::right << "|" << std::endl;
+    }
+    std::cout << "---------------------------------------------------------" << std::endl;
+    std::cout << std::endl;
+
+    return true;
+}
+
+}  // namespace sc2
@@ -0,0 +1,7 @@
+#pragma once
+
+namespace sc2 {
+
+bool BenchmarkLoopback(int argc, char** argv);
+
+}
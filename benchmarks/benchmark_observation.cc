@@ -0,0 +1,472 @@
+#include "benchmark_observation.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "benchmark_response_arena.h"
+#include "s2clientprotocol/sc2api.pb.h"
+#include "sc2api/sc2_api.h"
+#include "sc2api/sc2_proto_to_pods.h"
+#include "sc2api/sc2_unit_filters.h"
+#include "sc2fakeserver/sc2_fake_game.h"
+#include "sc2lib/sc2_search.h"
+
+using namespace std::chrono;
+
+namespace sc2 {
+
+namespace {
+
+const int kIterations = 100;
+const int kExpansionIterations = 5;
+
+// Recorded fixtures are serialized SC2APIProtocol::Response messages named after the scenario, e.g.
+// late_game.pb, along with the game_info.pb and data.pb responses of the same game. Scenarios without a recording
+// are synthesized with a comparable number of units.
+struct Scenario {
+    const char* name;
+    int own_units;
+    int enemy_units;
+    int actions;
+};
+
+const Scenario kScenarios[] = {
+    {"early_game", 20, 4, 0},
+    {"late_game", 230, 120, 0},
+    {"replay_frame", 450, 450, 40},
+};
+
+bool ReadFixture(const std::string& path, SC2APIProtocol::Response& response) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::stringstream data;
+    data << file.rdbuf();
+    return response.ParseFromString(data.str());
+}
+
+std::string GetFixtureDirectory(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--fixtures") == 0) {
+            return argv[i + 1];
+        }
+    }
+
+    return std::string();
+}
+
+class BenchmarkBot : public Agent {};
+
+// Steps the game outside of the measurements, so that every observation is a new frame.
+bool StepGame(ControlInterface* control) {
+    GameRequestPtr request = control->Proto().MakeRequest();
+    request->mutable_step()->set_count(1);
+    if (!control->Proto().SendRequest(request)) {
+        return false;
+    }
+
+    const GameResponsePtr response = control->Proto().WaitForResponseInternal();
+    return response && response->has_step();
+}
+
+struct ObservationStats {
+    std::string name;
+    bool recorded;
+    size_t unit_count;
+    double parse;
+    double convert;
+    double convert_allocations;
+    double first_convert;
+    double first_convert_allocations;
+    double get_observation;
+    double issue_events;
+    double get_units;
+    double expansions;
+    size_t expansion_count;
+};
+
+double ElapsedMicroseconds(high_resolution_clock::time_point start, int iterations) {
+    return duration_cast<duration<double>>(high_resolution_clock::now() - start).count() * 1e6 / iterations;
+}
+
+bool RunScenario(const Scenario& scenario, const std::string& fixture_directory, ObservationStats& stats) {
+    FakeGameSettings settings;
+    settings.own_units = scenario.own_units;
+    settings.enemy_units = scenario.enemy_units;
+    settings.actions = scenario.actions;
+    settings.seed = static_cast<uint32_t>(scenario.own_units);
+    FakeGame game(settings);
+
+    SC2APIProtocol::Response game_info;
+    SC2APIProtocol::Response data;
+    SC2APIProtocol::Response observation;
+
+    stats = ObservationStats();
+    stats.name = scenario.name;
+    stats.recorded = !fixture_directory.empty() &&
+                     ReadFixture(fixture_directory + "/" + scenario.name + ".pb", observation) &&
+                     ReadFixture(fixture_directory + "/game_info.pb", game_info) &&
+                     ReadFixture(fixture_directory + "/data.pb", data);
+    if (stats.recorded) {
+        game.SetResponse(game_info);
+        game.SetResponse(data);
+        game.SetResponse(observation);
+    } else {
+        observation = game.GetResponse(SC2APIProtocol::Response::kObservation);
+    }
+
+    if (!observation.has_observation() || !observation.observation().observation().has_raw_data()) {
+        std::cerr << "The " << scenario.name << " fixture doesn't hold a raw observation." << std::endl;
+        return false;
+    }
+
+    const std::string bytes = observation.SerializeAsString();
+    stats.unit_count = observation.observation().observation().raw_data().units_size();
+
+    // Decoding the bytes received off the socket.
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        SC2APIProtocol::Response response;
+        response.ParseFromString(bytes);
+    }
+    stats.parse = ElapsedMicroseconds(start, kIterations);
+
+    // Converting the raw units alone.
+    GameResponsePtr response = std::make_shared<const SC2APIProtocol::Response>(observation);
+    ObservationRawPtr observation_raw;
+    observation_raw.Set(response, &response->observation().observation().raw_data());
+    UnitPool unit_pool;
+    size_t allocations = GetAllocationCount();
+    start = high_resolution_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        unit_pool.ClearExisting();
+        Convert(observation_raw, unit_pool, i + 2, i + 1);
+        unit_pool.IndexExistingUnits();
+    }
+    stats.convert = ElapsedMicroseconds(start, kIterations);
+    stats.convert_allocations = static_cast<double>(GetAllocationCount() - allocations) / kIterations;
+
+    // Converting into an empty pool, as when the units are seen for the first time.
+    double first_convert = 0.0;
+    allocations = 0;
+    for (int i = 0; i < kIterations; ++i) {
+        UnitPool first_pool;
+        const size_t allocations_before = GetAllocationCount();
+        start = high_resolution_clock::now();
+        first_pool.ClearExisting();
+        Convert(observation_raw, first_pool, 1, 0);
+        first_pool.IndexExistingUnits();
+        first_convert += ElapsedMicroseconds(start, kIterations);
+        allocations += GetAllocationCount() - allocations_before;
+    }
+    stats.first_convert = first_convert;
+    stats.first_convert_allocations = static_cast<double>(allocations) / kIterations;
+
+    // The same observation over again, none of the units changed since the first conversion.
+    if (!unit_pool.GetChangedUnits().empty()) {
+        std::cerr << unit_pool.GetChangedUnits().size() << " units of the " << scenario.name
+                  << " fixture are reported changed by a repeated observation." << std::endl;
+        return false;
+    }
+
+    // The full step of a client, answered in process.
+    BenchmarkBot bot;
+    bot.Control()->Proto().SetRequestHandler(
+        [&game](const SC2APIProtocol::Request& request) { return game.Answer(request); });
+
+    // Join the game so that steps advance the game loop.
+    SC2APIProtocol::Request join_game;
+    join_game.mutable_join_game();
+    delete game.Answer(join_game);
+
+    // Warm up the data caches and the unit pool.
+    bool success = StepGame(bot.Control()) && bot.Control()->GetObservation() && bot.Control()->IssueEvents();
+
+    double get_observation = 0.0;
+    double issue_events = 0.0;
+    for (int i = 0; i < kIterations; ++i) {
+        success = StepGame(bot.Control()) && success;
+
+        start = high_resolution_clock::now();
+        success = bot.Control()->GetObservation() && success;
+        get_observation += ElapsedMicroseconds(start, kIterations);
+
+        start = high_resolution_clock::now();
+        success = bot.Control()->IssueEvents() && success;
+        issue_events += ElapsedMicroseconds(start, kIterations);
+    }
+    stats.get_observation = get_observation;
+    stats.issue_events = issue_events;
+
+    // The queries a bot typically runs every step.
+    const ObservationInterface* obs = bot.Observation();
+    size_t matched = 0;
+    start = high_resolution_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        matched += obs->GetUnits(Unit::Alliance::Self, IsWorker()).size();
+        matched += obs->GetUnits(Unit::Alliance::Self, IsTownHall()).size();
+        matched += obs->GetUnits(Unit::Alliance::Self, IsUnit(UNIT_TYPEID::TERRAN_MARINE)).size();
+        matched += obs->GetUnits(Unit::Alliance::Neutral, IsMineralPatch()).size();
+        matched += obs->GetUnits(Unit::Alliance::Enemy).size();
+        matched += obs->GetUnits([](const Unit& unit) { return unit.orders.empty(); }).size();
+    }
+    stats.get_units = ElapsedMicroseconds(start, kIterations);
+
+    std::vector<Point3D> expansions;
+    start = high_resolution_clock::now();
+    for (int i = 0; i < kExpansionIterations; ++i) {
+        expansions = search::CalculateExpansionLocations(obs, bot.Query());
+    }
+    stats.expansions = ElapsedMicroseconds(start, kExpansionIterations) / 1000.0;
+    stats.expansion_count = expansions.size();
+
+    if (obs->GetUnits().size() != stats.unit_count || expansions.empty() || matched == 0) {
+        success = false;
+    }
+
+    // Paths from a unit start at its position, the game answers 0 for a unit it doesn't know as for an unreachable
+    // target.
+    const Units own_units = obs->GetUnits(Unit::Alliance::Self);
+    if (!own_units.empty()) {
+        QueryInterface::PathingQuery from_unit;
+        from_unit.start_unit_tag_ = own_units.front()->tag;
+        from_unit.end_ = Point2D(own_units.front()->pos) + Point2D(3.0F, 4.0F);
+        QueryInterface::PathingQuery from_unknown = from_unit;
+        from_unknown.start_unit_tag_ = std::numeric_limits<Tag>::max();
+        const std::vector<float> distances = bot.Query()->PathingDistance({from_unit, from_unknown});
+        if (distances.size() != 2 || std::abs(distances[0] - 5.0F) > 0.01F || distances[1] != 0.0F) {
+            std::cerr << "Pathing from a unit of the " << scenario.name << " fixture answered the wrong distances."
+                      << std::endl;
+            success = false;
+        }
+    }
+
+    // Every unit has its own index below the maximum.
+    std::vector<bool> indexed(obs->GetMaxUnitIndex(), false);
+    for (const Unit* unit : obs->GetUnits()) {
+        if (unit->index >= indexed.size() || indexed[unit->index]) {
+            success = false;
+            break;
+        }
+        indexed[unit->index] = true;
+    }
+
+    if (!success) {
+        std::cerr << "Running the " << scenario.name << " fixture failed." << std::endl;
+    }
+
+    return success;
+}
+
+// Converts an observation of the given units the way the client does, reclaiming dead units first.
+void ObserveUnits(UnitPool& unit_pool, const std::vector<Tag>& tags, uint32_t game_loop) {
+    unit_pool.ReclaimDeadUnits(game_loop);
+    unit_pool.ClearExisting();
+    for (Tag tag : tags) {
+        Unit* unit = unit_pool.CreateUnit(tag);
+        unit->tag = tag;
+        unit->is_alive = true;
+        unit->last_seen_game_loop = game_loop;
+    }
+    unit_pool.IndexExistingUnits();
+}
+
+// Dead units are kept for the game by default and reclaimed after their retention otherwise, their slots and indices
+// go to the next new units. Resetting the pool forgets all units.
+bool CheckUnitPool() {
+    UnitPool unit_pool;
+    bool success = true;
+
+    ObserveUnits(unit_pool, {1, 2, 3, 4, 5}, 1);
+    unit_pool.MarkDead(3);
+    ObserveUnits(unit_pool, {1, 2, 4, 5}, 100);
+    UnitPoolReport report = unit_pool.GetReport();
+    success = report.units == 5 && report.existing_units == 4 && report.dead_units == 1 && report.free_slots == 0;
+    success = unit_pool.GetUnit(3) && success;
+
+    // The unit that died meanwhile is reclaimed once its retention ends, the one dying now is kept until then.
+    unit_pool.SetDeadUnitRetention(10);
+    const Unit* reclaimed = unit_pool.GetUnit(3);
+    const uint32_t reclaimed_index = reclaimed->index;
+    unit_pool.MarkDead(5);
+    ObserveUnits(unit_pool, {1, 2, 4}, 105);
+    report = unit_pool.GetReport();
+    success = !unit_pool.GetUnit(3) && unit_pool.GetUnit(5) && success;
+    success = report.units == 4 && report.dead_units == 1 && report.free_slots == 1 && success;
+
+    // A new unit takes the freed slot and its index, a unit seen again after its death is alive and stays.
+    ObserveUnits(unit_pool, {1, 2, 4, 5, 6}, 108);
+    ObserveUnits(unit_pool, {1, 2, 4, 5, 6}, 200);
+    const Unit* reused = unit_pool.GetUnit(6);
+    report = unit_pool.GetReport();
+    success = reused == reclaimed && reused->index == reclaimed_index && unit_pool.MaxIndex() == 5 && success;
+    success = unit_pool.GetUnit(5) && unit_pool.GetUnit(5)->is_alive && success;
+    success = report.units == 5 && report.existing_units == 5 && report.dead_units == 0 && report.free_slots == 0 &&
+              success;
+
+    unit_pool.Reset();
+    report = unit_pool.GetReport();
+    success = report.units == 0 && report.existing_units == 0 && report.free_slots == 0 && report.slots > 0 &&
+              unit_pool.MaxIndex() == 0 && !unit_pool.GetUnit(1) && success;
+    ObserveUnits(unit_pool, {7}, 1);
+    success = unit_pool.GetUnit(7)->index == 0 && success;
+
+    if (!success) {
+        std::cerr << "The unit pool didn't reclaim, reuse or reset its units as expected." << std::endl;
+    }
+
+    return success;
+}
+
+struct UnitDeathStats {
+    size_t unit_count;
+    size_t deaths;
+    double microseconds;
+};
+
+// A fight in which some of the units of the observation die, every unit changed and grouped by alliance and type. Times
+// marking them dead along with removing them from the lists of existing units.
+bool RunUnitDeaths(size_t unit_count, size_t deaths, UnitDeathStats& stats) {
+    static const Unit::Alliance alliances[] = {Unit::Alliance::Self, Unit::Alliance::Enemy, Unit::Alliance::Neutral};
+    static const UNIT_TYPEID types[] = {UNIT_TYPEID::TERRAN_SCV,      UNIT_TYPEID::TERRAN_MARINE,
+                                        UNIT_TYPEID::TERRAN_MARAUDER, UNIT_TYPEID::TERRAN_SIEGETANK,
+                                        UNIT_TYPEID::ZERG_ROACH,      UNIT_TYPEID::ZERG_ZERGLING,
+                                        UNIT_TYPEID::NEUTRAL_MINERALFIELD};
+
+    UnitPool unit_pool;
+    const size_t spacing = unit_count / deaths;
+    bool success = true;
+    double elapsed = 0.0;
+    for (int i = 0; i < kIterations; ++i) {
+        unit_pool.ClearExisting();
+        for (size_t index = 0; index < unit_count; ++index) {
+            Unit* unit = unit_pool.CreateUnit(index + 1);
+            unit->tag = index + 1;
+            unit->is_alive = true;
+            unit->alliance = alliances[index % 3];
+            unit->unit_type = types[(index / 3) % 7];
+            unit->changed_fields = Unit::ChangedPosition | Unit::ChangedHealth;
+            unit_pool.AddUnitChanged(unit);
+        }
+        unit_pool.IndexExistingUnits();
+
+        const high_resolution_clock::time_point start = high_resolution_clock::now();
+        for (size_t death = 0; death < deaths; ++death) {
+            unit_pool.MarkDead(death * spacing + 1);
+        }
+        unit_pool.RemoveDeadExistingUnits();
+        elapsed += ElapsedMicroseconds(start, kIterations);
+
+        size_t grouped = 0;
+        for (Unit::Alliance alliance : alliances) {
+            grouped += unit_pool.GetExistingUnits(alliance).size();
+            for (UnitTypeID type : unit_pool.GetExistingUnitTypes(alliance)) {
+                success = !unit_pool.GetExistingUnits(alliance, type).empty() && success;
+            }
+        }
+        const size_t alive = unit_count - deaths;
+        success = unit_pool.GetExistingUnits().size() == alive && unit_pool.GetChangedUnits().size() == alive &&
+                  grouped == alive && success;
+    }
+
+    stats.unit_count = unit_count;
+    stats.deaths = deaths;
+    stats.microseconds = elapsed;
+
+    if (!success) {
+        std::cerr << "Dead units remained among the existing units of the pool." << std::endl;
+    }
+
+    return success;
+}
+
+}  // namespace
+
+bool BenchmarkObservation(int argc, char** argv) {
+    const std::string fixture_directory = GetFixtureDirectory(argc, argv);
+
+    bool success = CheckUnitPool();
+    std::vector<ObservationStats> results;
+    for (const Scenario& scenario : kScenarios) {
+        ObservationStats stats;
+        success = RunScenario(scenario, fixture_directory, stats) && success;
+        results.push_back(stats);
+    }
+
+    std::cout << std::endl;
+    std::cout << "Client cost per step (us), expansions (ms)" << std::endl;
+    std::cout << "--------------------------------------------------------------------------------------------------"
+              << std::endl;
+    std::cout << "|" << std::setw(14) << std::left << "Fixture" << std::right << "|" << std::setw(7) << std::left
+              << "Units" << std::right << "|" << std::setw(10) << std::left << "Parse" << std::right << "|"
+              << std::setw(10) << std::left << "Convert" << std::right << "|" << std::setw(14) << std::left
+              << "Observation" << std::right << "|" << std::setw(10) << std::left << "Events" << std::right << "|"
+              << std::setw(10) << std::left << "GetUnits" << std::right << "|" << std::setw(12) << std::left
+              << "Expansions" << std::right << "|" << std::endl;
+    for (const ObservationStats& stats : results) {
+        std::cout << "|" << std::setw(14) << std::left << (stats.name + (stats.recorded ? "" : "*")) << std::right
+                  << "|" << std::setw(7) << std::left << stats.unit_count << std::right << "|" << std::setw(10)
+                  << std::left << stats.parse << std::right << "|" << std::setw(10) << std::left << stats.convert
+                  << std::right << "|" << std::setw(14) << std::left << stats.get_observation << std::right << "|"
+                  << std::setw(10) << std::left << stats.issue_events << std::right << "|" << std::setw(10)
+                  << std::left << stats.get_units << std::right << "|" << std::setw(12) << std::left
+                  << stats.expansions << std::right << "|" << std::endl;
+    }
+    std::cout << "--------------------------------------------------------------------------------------------------"
+              << std::endl;
+    std::cout << "Observation includes parsing the response. * Synthetic fixture, pass --fixtures <dir> to use recorded"
+              << " ones." << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "Unit conversion per step, in (us) and heap allocations" << std::endl;
+    std::cout << "------------------------------------------------------------------" << std::endl;
+    std::cout << "|" << std::setw(14) << std::left << "Fixture" << std::right << "|" << std::setw(12) << std::left
+              << "Convert" << std::right << "|" << std::setw(12) << std::left << "Allocations" << std::right << "|"
+              << std::setw(12) << std::left << "First seen" << std::right << "|" << std::setw(12) << std::left
+              << "Allocations" << std::right << "|" << std::endl;
+    for (const ObservationStats& stats : results) {
+        std::cout << "|" << std::setw(14) << std::left << (stats.name + (stats.recorded ? "" : "*")) << std::right
+                  << "|" << std::setw(12) << std::left << stats.convert << std::right << "|" << std::setw(12)
+                  << std::left << stats.convert_allocations << std::right << "|" << std::setw(12) << std::left
+                  << stats.first_convert << std::right << "|" << std::setw(12) << std::left
+                  << stats.first_convert_allocations << std::right << "|" << std::endl;
+    }
+    std::cout << "------------------------------------------------------------------" << std::endl;
+    std::cout << "First seen converts into an empty unit pool, every unit is new." << std::endl;
+    std::cout << std::endl;
+
+    static const size_t death_counts[][2] = {{350, 50}, {1000, 200}, {3000, 600}};
+    std::vector<UnitDeathStats> deaths;
+    for (const auto& count : death_counts) {
+        UnitDeathStats stats = UnitDeathStats();
+        success = RunUnitDeaths(count[0], count[1], stats) && success;
+        deaths.push_back(stats);
+    }
+
+    std::cout << "Units of the observation dying in a step (us)" << std::endl;
+    std::cout << "----------------------------------" << std::endl;
+    std::cout << "|" << std::setw(8) << std::left << "Units" << std::right << "|" << std::setw(10) << std::left
+              << "Deaths" << std::right << "|" << std::setw(12) << std::left << "Mark dead" << std::right << "|"
+              << std::endl;
+    for (const UnitDeathStats& stats : deaths) {
+        std::cout << "|" << std::setw(8) << std::left << stats.unit_count << std::right << "|" << std::setw(10)
+                  << std::left << stats.deaths << std::right << "|" << std::setw(12) << std::left
+                  << stats.microseconds << std::right << "|" << std::endl;
+    }
+    std::cout << "----------------------------------" << std::endl;
+    std::cout << std::endl;
+
+    return success;
+}
+
+}  // namespace sc2
@@ -0,0 +1,171 @@
+#include "benchmark_response_arena.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include "s2clientprotocol/sc2api.pb.h"
+#include "sc2api/sc2_connection.h"
+
+using namespace std::chrono;
+
+// Counts every heap allocation of the benchmark executable, protobuf included.
+static std::atomic<size_t> allocation_count(0);
+
+void* operator new(size_t size) {
+    ++allocation_count;
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+namespace sc2 {
+
+size_t GetAllocationCount() {
+    return allocation_count;
+}
+
+namespace {
+
+const int kIterations = 200;
+const int kUnitCount = 1000;
+const int kMapSize = 200;
+
+// An observation of a late game with a busy map.
+std::string CreateObservation() {
+    SC2APIProtocol::Response response;
+    response.set_status(SC2APIProtocol::in_game);
+    SC2APIProtocol::Observation* observation = response.mutable_observation()->mutable_observation();
+    observation->set_game_loop(20000);
+
+    SC2APIProtocol::ObservationRaw* raw = observation->mutable_raw_data();
+    for (int i = 0; i < kUnitCount; ++i) {
+        SC2APIProtocol::Unit* unit = raw->add_units();
+        unit->set_display_type(SC2APIProtocol::Visible);
+        unit->set_alliance(i % 2 ? SC2APIProtocol::Self : SC2APIProtocol::Enemy);
+        unit->set_tag(4294967297ULL + i);
+        unit->set_unit_type(48);
+        unit->set_owner(i % 2 + 1);
+        unit->mutable_pos()->set_x(static_cast<float>(i % kMapSize));
+        unit->mutable_pos()->set_y(static_cast<float>(i / kMapSize));
+        unit->mutable_pos()->set_z(10.0F);
+        unit->set_facing(1.0F);
+        unit->set_radius(0.375F);
+        unit->set_build_progress(1.0F);
+        unit->set_health(45.0F);
+        unit->set_health_max(45.0F);
+        unit->set_weapon_cooldown(0.5F);
+        if (i % 3 == 0) {
+            SC2APIProtocol::UnitOrder* order = unit->add_orders();
+            order->set_ability_id(23);
+            order->mutable_target_world_space_pos()->set_x(100.0F);
+            order->mutable_target_world_space_pos()->set_y(100.0F);
+        }
+        if (i % 10 == 0) {
+            unit->add_buff_ids(27);
+        }
+    }
+
+    SC2APIProtocol::MapState* map_state = raw->mutable_map_state();
+    map_state->mutable_visibility()->set_bits_per_pixel(8);
+    map_state->mutable_visibility()->mutable_size()->set_x(kMapSize);
+    map_state->mutable_visibility()->mutable_size()->set_y(kMapSize);
+    map_state->mutable_visibility()->set_data(std::string(kMapSize * kMapSize, '\x02'));
+    map_state->mutable_creep()->set_bits_per_pixel(1);
+    map_state->mutable_creep()->mutable_size()->set_x(kMapSize);
+    map_state->mutable_creep()->mutable_size()->set_y(kMapSize);
+    map_state->mutable_creep()->set_data(std::string(kMapSize * kMapSize / 8, '\x0f'));
+
+    return response.SerializeAsString();
+}
+
+struct ParseStats {
+    double allocations;
+    double microseconds;
+};
+
+// Goes through the same path as a response received off the socket, keeping the previous observation alive like the
+// client does.
+bool RunParse(const std::string& data, bool use_arenas, ParseStats& stats) {
+    Connection connection;
+    connection.SetUseResponseArenas(use_arenas);
+
+    bool success = true;
+    GameResponsePtr previous;
+    size_t allocations = 0;
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        const size_t allocations_before = allocation_count;
+
+        SC2APIProtocol::Response* received = connection.CreateResponse();
+        if (!received->ParseFromArray(data.data(), static_cast<int>(data.size()))) {
+            connection.ReleaseResponse(received);
+            return false;
+        }
+        connection.PushResponse(received);
+
+        GameResponsePtr response;
+        if (!connection.Receive(response, 1000) || !response) {
+            return false;
+        }
+        success = success && response->observation().observation().raw_data().units_size() == kUnitCount;
+        previous = response;
+
+        allocations += allocation_count - allocations_before;
+    }
+    const double seconds = duration_cast<duration<double>>(high_resolution_clock::now() - start).count();
+
+    stats.allocations = static_cast<double>(allocations) / kIterations;
+    stats.microseconds = seconds * 1e6 / kIterations;
+    return success;
+}
+
+}  // namespace
+
+bool BenchmarkResponseArena(int, char**) {
+    const std::string data = CreateObservation();
+
+    ParseStats heap;
+    ParseStats arena;
+    bool success = RunParse(data, false, heap);
+    success = RunParse(data, true, arena) && success;
+
+    // Once the arenas are warm a response should cost a handful of allocations instead of one per submessage.
+    if (arena.allocations * 10 > heap.allocations) {
+        std::cerr << "Response arenas didn't reduce the allocations." << std::endl;
+        success = false;
+    }
+
+    std::cout << std::endl;
+    std::cout << "Parsing an observation of " << kUnitCount << " units, " << data.size() << " bytes" << std::endl;
+    std::cout << "--------------------------------------------" << std::endl;
+    std::cout << "|" << std::setw(10) << std::left << "Mode" << std::right << "|" << std::setw(16) << std::left
+              << "Allocations" << std::right << "|" << std::setw(14) << std::left << "us/response" << std::right << "|"
+              << std::endl;
+    std::cout << "|" << std::setw(10) << std::left << "Heap" << std::right << "|" << std::setw(16) << std::left
+              << heap.allocations << std::right << "|" << std::setw(14) << std::left << heap.microseconds << std::right
+              << "|" << std::endl;
+    std::cout << "|" << std::setw(10) << std::left << "Arena" << std::right << "|" << std::setw(16) << std::left
+              << arena.allocations << std::right << "|" << std::setw(14) << std::left << arena.microseconds
+              << std::right << "|" << std::endl;
+    std::cout << "--------------------------------------------" << std::endl;
+    std::cout << std::endl;
+
+    return success;
+}
+
+}  // namespace sc2
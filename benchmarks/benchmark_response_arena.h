@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stddef.h>
+
+namespace sc2 {
+
+// The number of heap allocations made by the benchmark executable so far.
+size_t GetAllocationCount();
+
+bool BenchmarkResponseArena(int argc, char** argv);
+
+}
@@ -0,0 +1,170 @@
+#include "benchmark_spatial_index.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "benchmark_units.h"
+#include "sc2api/sc2_api.h"
+#include "sc2lib/sc2_spatial_index.h"
+
+using namespace std::chrono;
+
+namespace sc2 {
+
+namespace {
+
+struct SpatialIndexStats {
+    size_t unit_count;
+    double rebuild;
+    double radius_index;
+    double radius_brute_force;
+    double nearest_index;
+    double nearest_brute_force;
+};
+
+// The index against the same queries scanning all units.
+bool RunSpatialIndex(size_t unit_count, SpatialIndexStats& stats) {
+    const BenchmarkUnits benchmark_units(unit_count);
+    const Units& units = benchmark_units.GetUnits();
+    const Units& own_units = benchmark_units.GetOwnUnits();
+
+    UnitSpatialIndex index;
+    bool success = true;
+    size_t radius_matches = 0;
+    size_t radius_expected = 0;
+
+    stats = SpatialIndexStats();
+    stats.unit_count = unit_count;
+
+    Units in_range;
+    for (int step = 0; step < kTargetingSteps; ++step) {
+        high_resolution_clock::time_point start = high_resolution_clock::now();
+        index.Update(units);
+        stats.rebuild += StepMilliseconds(start);
+
+        start = high_resolution_clock::now();
+        for (const Unit* unit : own_units) {
+            radius_matches += index.GetUnitsInRadius(unit->pos, kTargetingRadius, Unit::Alliance::Enemy).size();
+        }
+        stats.radius_index += StepMilliseconds(start);
+
+        start = high_resolution_clock::now();
+        for (const Unit* unit : own_units) {
+            in_range.clear();
+            ScanUnitsInRange(units, unit->pos, kTargetingRadius, Unit::Alliance::Enemy, in_range);
+            radius_expected += in_range.size();
+        }
+        stats.radius_brute_force += StepMilliseconds(start);
+
+        Units nearest;
+        start = high_resolution_clock::now();
+        for (const Unit* unit : own_units) {
+            Units found = index.GetNearestUnits(unit->pos, 1, Unit::Alliance::Enemy);
+            nearest.push_back(found.empty() ? nullptr : found.front());
+        }
+        stats.nearest_index += StepMilliseconds(start);
+
+        Units nearest_expected;
+        start = high_resolution_clock::now();
+        for (const Unit* unit : own_units) {
+            nearest_expected.push_back(ScanNearestUnit(units, unit->pos, Unit::Alliance::Enemy));
+        }
+        stats.nearest_brute_force += StepMilliseconds(start);
+
+        for (size_t i = 0; i < own_units.size(); ++i) {
+            if (nearest[i] == nearest_expected[i]) {
+                continue;
+            }
+
+            // Equally distant units are a valid answer too.
+            if (!nearest[i] || !nearest_expected[i] ||
+                DistanceSquared2D(own_units[i]->pos, nearest[i]->pos) !=
+                    DistanceSquared2D(own_units[i]->pos, nearest_expected[i]->pos)) {
+                success = false;
+            }
+        }
+    }
+
+    if (radius_matches != radius_expected) {
+        success = false;
+    }
+
+    if (!success) {
+        std::cerr << "Spatial index results differ from brute force with " << unit_count << " units." << std::endl;
+    }
+
+    return success;
+}
+
+// Queries beyond the extent of the units must find nothing rather than read cells outside of the grid.
+bool CheckOutOfExtent() {
+    UnitPool unit_pool;
+    std::mt19937 generator(100);
+    std::uniform_real_distribution<float> position(10.0F, 46.0F);
+
+    Units units;
+    for (Tag tag = 1; tag <= 100; ++tag) {
+        Unit* unit = unit_pool.CreateUnit(tag);
+        unit->tag = tag;
+        unit->alliance = Unit::Alliance::Enemy;
+        unit->pos = Point3D(position(generator), position(generator), 0.0F);
+        units.push_back(unit);
+    }
+
+    UnitSpatialIndex index;
+    index.Update(units);
+
+    bool success = index.GetUnitsInBox({Point2D(200.0F, 40.0F), Point2D(210.0F, 50.0F)}).empty();
+    success = index.GetUnitsInBox({Point2D(-50.0F, 20.0F), Point2D(-40.0F, 30.0F)}).empty() && success;
+    success = index.GetUnitsInRadius(Point2D(300.0F, 40.0F), 5.0F).empty() && success;
+    success = index.GetUnitsInRadius(Point2D(1e30F, -1e30F), 5.0F).empty() && success;
+
+    const Units nearest = index.GetNearestUnits(Point2D(300.0F, 40.0F), 1);
+    success = nearest.size() == 1 &&
+              nearest.front() == ScanNearestUnit(units, Point2D(300.0F, 40.0F), Unit::Alliance::Enemy) && success;
+
+    if (!success) {
+        std::cerr << "Spatial index queries beyond the extent of the units are wrong." << std::endl;
+    }
+
+    return success;
+}
+
+}  // namespace
+
+bool BenchmarkSpatialIndex(int, char**) {
+    static const size_t unit_counts[] = {200, 1000, 3000};
+
+    bool success = CheckOutOfExtent();
+    std::vector<SpatialIndexStats> results;
+    for (size_t unit_count : unit_counts) {
+        SpatialIndexStats stats;
+        success = RunSpatialIndex(unit_count, stats) && success;
+        results.push_back(stats);
+    }
+
+    std::cout << std::endl;
+    std::cout << "Spatial index, radius " << kTargetingRadius << " and nearest enemy for every own unit (ms per step)"
+              << std::endl;
+    std::cout << "----------------------------------------------------------------------------------" << std::endl;
+    std::cout << "|" << std::setw(8) << std::left << "Units" << std::right << "|" << std::setw(10) << std::left
+              << "Rebuild" << std::right << "|" << std::setw(14) << std::left << "Radius index" << std::right << "|"
+              << std::setw(14) << std::left << "Radius brute" << std::right << "|" << std::setw(15) << std::left
+              << "Nearest index" << std::right << "|" << std::setw(15) << std::left << "Nearest brute" << std::right
+              << "|" << std::endl;
+    for (const SpatialIndexStats& stats : results) {
+        std::cout << "|" << std::setw(8) << std::left << stats.unit_count << std::right << "|" << std::setw(10)
+                  << std::left << stats.rebuild << std::right << "|" << std::setw(14) << std::left
+                  << stats.radius_index << std::right << "|" << std::setw(14) << std::left << stats.radius_brute_force
+                  << std::right << "|" << std::setw(15) << std::left << stats.nearest_index << std::right << "|"
+                  << std::setw(15) << std::left << stats.nearest_brute_force << std::right << "|" << std::endl;
+    }
+    std::cout << "----------------------------------------------------------------------------------" << std::endl;
+    std::cout << std::endl;
+
+    return success;
+}
+
+}  // namespace sc2
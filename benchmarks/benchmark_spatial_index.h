@@ -0,0 +1,7 @@
+#pragma once
+
+namespace sc2 {
+
+bool BenchmarkSpatialIndex(int argc, char** argv);
+
+}
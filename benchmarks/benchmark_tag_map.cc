@@ -0,0 +1,184 @@
+#include "benchmark_tag_map.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "sc2api/sc2_api.h"
+
+using namespace std::chrono;
+
+namespace sc2 {
+
+namespace {
+
+const int kIterations = 200;
+
+// Unit tags hold the unit index in their low 18 bits and count how often the index was reused above.
+Tag MakeTag(uint32_t index, uint32_t recycle) {
+    return (static_cast<Tag>(recycle) << 18) | index;
+}
+
+// Fills the pool with units of scattered indices, every third one ours with orders on the other units the way workers
+// and army units target minerals and enemies. Some orders target units that died or were never seen.
+Units CreateUnits(UnitPool& unit_pool, size_t count, std::mt19937& generator) {
+    std::uniform_int_distribution<uint32_t> index(0, (1 << 18) - 1);
+    std::uniform_int_distribution<size_t> other(0, count - 1);
+    std::uniform_real_distribution<float> chance(0.0F, 1.0F);
+
+    Units units;
+    while (units.size() < count) {
+        const Tag tag = MakeTag(index(generator), 1 + generator() % 4);
+        if (unit_pool.GetUnit(tag)) {
+            continue;
+        }
+
+        Unit* unit = unit_pool.CreateUnit(tag);
+        unit->tag = tag;
+        unit->alliance = units.size() % 3 == 0 ? Unit::Alliance::Self : Unit::Alliance::Enemy;
+        units.push_back(unit);
+    }
+
+    for (const Unit* unit : units) {
+        if (unit->alliance != Unit::Alliance::Self) {
+            continue;
+        }
+
+        Unit* own_unit = unit_pool.GetUnit(unit->tag);
+        const int orders = 1 + static_cast<int>(generator() % 2);
+        for (int i = 0; i < orders; ++i) {
+            UnitOrder order;
+            order.target_unit_tag = units[other(generator)]->tag;
+            if (chance(generator) < 0.1F) {
+                order.target_unit_tag = MakeTag(index(generator), 7);
+            }
+            own_unit->orders.push_back(order);
+        }
+    }
+
+    return units;
+}
+
+struct TagMapStats {
+    size_t unit_count;
+    size_t lookups;
+    double lookup_pool;
+    double lookup_unordered;
+    double insert_pool;
+    double insert_unordered;
+};
+
+// A step of a bot that resolves the target of every order and finds the units it tracks by tag again.
+bool RunTagMap(size_t unit_count, TagMapStats& stats) {
+    std::mt19937 generator(static_cast<std::mt19937::result_type>(unit_count));
+    UnitPool unit_pool;
+    const Units units = CreateUnits(unit_pool, unit_count, generator);
+
+    std::unordered_map<Tag, const Unit*> unordered;
+    for (const Unit* unit : units) {
+        unordered.emplace(unit->tag, unit);
+    }
+
+    stats = TagMapStats();
+    stats.unit_count = unit_count;
+
+    bool success = true;
+    for (int iteration = 0; iteration < kIterations; ++iteration) {
+        size_t pool_found = 0;
+        high_resolution_clock::time_point start = high_resolution_clock::now();
+        for (const Unit* unit : units) {
+            for (const UnitOrder& order : unit->orders) {
+                pool_found += unit_pool.GetUnit(order.target_unit_tag) != nullptr;
+            }
+            pool_found += unit_pool.GetExistingUnit(unit->tag) == unit;
+        }
+        stats.lookup_pool += duration_cast<duration<double>>(high_resolution_clock::now() - start).count();
+
+        size_t unordered_found = 0;
+        size_t lookups = 0;
+        start = high_resolution_clock::now();
+        for (const Unit* unit : units) {
+            for (const UnitOrder& order : unit->orders) {
+                unordered_found += unordered.find(order.target_unit_tag) != unordered.end();
+            }
+            auto found = unordered.find(unit->tag);
+            unordered_found += found != unordered.end() && found->second == unit;
+            lookups += unit->orders.size() + 1;
+        }
+        stats.lookup_unordered += duration_cast<duration<double>>(high_resolution_clock::now() - start).count();
+        stats.lookups = lookups;
+
+        success = pool_found == unordered_found && success;
+
+        // Two inserts per unit and step, the existing units are indexed again for every observation.
+        start = high_resolution_clock::now();
+        unit_pool.ClearExisting();
+        for (const Unit* unit : units) {
+            unit_pool.CreateUnit(unit->tag);
+        }
+        stats.insert_pool += duration_cast<duration<double>>(high_resolution_clock::now() - start).count();
+
+        start = high_resolution_clock::now();
+        unordered.clear();
+        for (const Unit* unit : units) {
+            unordered.emplace(unit->tag, unit);
+        }
+        stats.insert_unordered += duration_cast<duration<double>>(high_resolution_clock::now() - start).count();
+
+        success = unit_pool.GetExistingUnits().size() == units.size() && success;
+    }
+
+    // Average per step in microseconds.
+    stats.lookup_pool *= 1e6 / kIterations;
+    stats.lookup_unordered *= 1e6 / kIterations;
+    stats.insert_pool *= 1e6 / kIterations;
+    stats.insert_unordered *= 1e6 / kIterations;
+
+    if (!success) {
+        std::cerr << "Unit pool lookups differ from std::unordered_map with " << unit_count << " units." << std::endl;
+    }
+
+    return success;
+}
+
+}  // namespace
+
+bool BenchmarkTagMap(int, char**) {
+    static const size_t unit_counts[] = {350, 1000, 3000};
+
+    bool success = true;
+    std::vector<TagMapStats> results;
+    for (size_t unit_count : unit_counts) {
+        TagMapStats stats;
+        success = RunTagMap(unit_count, stats) && success;
+        results.push_back(stats);
+    }
+
+    std::cout << std::endl;
+    std::cout << "Unit pool tag lookups of every order target and indexing of the existing units against"
+              << " std::unordered_map (us per step)" << std::endl;
+    std::cout << "-------------------------------------------------------------------------------------------"
+              << std::endl;
+    std::cout << "|" << std::setw(8) << std::left << "Units" << std::right << "|" << std::setw(10) << std::left
+              << "Lookups" << std::right << "|" << std::setw(14) << std::left << "Lookup pool" << std::right << "|"
+              << std::setw(18) << std::left << "Lookup unordered" << std::right << "|" << std::setw(14) << std::left
+              << "Index pool" << std::right << "|" << std::setw(18) << std::left << "Index unordered" << std::right
+              << "|" << std::endl;
+    for (const TagMapStats& stats : results) {
+        std::cout << "|" << std::setw(8) << std::left << stats.unit_count << std::right << "|" << std::setw(10)
+                  << std::left << stats.lookups << std::right << "|" << std::setw(14) << std::left
+                  << stats.lookup_pool << std::right << "|" << std::setw(18) << std::left << stats.lookup_unordered
+                  << std::right << "|" << std::setw(14) << std::left << stats.insert_pool << std::right << "|"
+                  << std::setw(18) << std::left << stats.insert_unordered << std::right << "|" << std::endl;
+    }
+    std::cout << "-------------------------------------------------------------------------------------------"
+              << std::endl;
+    std::cout << std::endl;
+
+    return success;
+}
+
+}  // namespace sc2
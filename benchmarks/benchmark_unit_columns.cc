@@ -0,0 +1,133 @@
+#include "benchmark_unit_columns.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "benchmark_units.h"
+#include "sc2api/sc2_api.h"
+
+using namespace std::chrono;
+
+namespace sc2 {
+
+namespace {
+
+struct UnitColumnsStats {
+    size_t unit_count;
+    double assign;
+    double range_columns;
+    double range_pointers;
+    double nearest_columns;
+    double nearest_pointers;
+};
+
+// The columns against the same queries scanning the units through their pointers. Both compare squared distances, so
+// the results must match exactly.
+bool RunUnitColumns(size_t unit_count, UnitColumnsStats& stats) {
+    const BenchmarkUnits benchmark_units(unit_count);
+    const Units& units = benchmark_units.GetUnits();
+    const Units& own_units = benchmark_units.GetOwnUnits();
+
+    UnitColumns columns;
+    bool success = true;
+    Units in_range;
+    Units in_range_pointers;
+
+    stats = UnitColumnsStats();
+    stats.unit_count = unit_count;
+
+    for (int step = 0; step < kTargetingSteps; ++step) {
+        high_resolution_clock::time_point start = high_resolution_clock::now();
+        columns.Assign(units);
+        stats.assign += StepMilliseconds(start);
+
+        std::vector<size_t> range_columns;
+        start = high_resolution_clock::now();
+        for (const Unit* unit : own_units) {
+            in_range.clear();
+            columns.GetUnitsInRange(unit->pos, kTargetingRadius, Unit::Alliance::Enemy, in_range);
+            range_columns.push_back(in_range.size());
+        }
+        stats.range_columns += StepMilliseconds(start);
+
+        std::vector<size_t> range_pointers;
+        start = high_resolution_clock::now();
+        for (const Unit* unit : own_units) {
+            in_range_pointers.clear();
+            ScanUnitsInRange(units, unit->pos, kTargetingRadius, Unit::Alliance::Enemy, in_range_pointers);
+            range_pointers.push_back(in_range_pointers.size());
+        }
+        stats.range_pointers += StepMilliseconds(start);
+
+        Units nearest;
+        start = high_resolution_clock::now();
+        for (const Unit* unit : own_units) {
+            nearest.push_back(columns.GetNearestUnit(unit->pos, Unit::Alliance::Enemy));
+        }
+        stats.nearest_columns += StepMilliseconds(start);
+
+        Units nearest_pointers;
+        start = high_resolution_clock::now();
+        for (const Unit* unit : own_units) {
+            nearest_pointers.push_back(ScanNearestUnit(units, unit->pos, Unit::Alliance::Enemy));
+        }
+        stats.nearest_pointers += StepMilliseconds(start);
+
+        success = range_columns == range_pointers && nearest == nearest_pointers && success;
+    }
+
+    // The units in range in the order of the scan, not only as many of them.
+    for (const Unit* unit : own_units) {
+        in_range.clear();
+        in_range_pointers.clear();
+        columns.GetUnitsInRange(unit->pos, kTargetingRadius, Unit::Alliance::Enemy, in_range);
+        ScanUnitsInRange(units, unit->pos, kTargetingRadius, Unit::Alliance::Enemy, in_range_pointers);
+        success = in_range == in_range_pointers && success;
+    }
+
+    if (!success) {
+        std::cerr << "Unit columns results differ from a scan of the units with " << unit_count << " units."
+                  << std::endl;
+    }
+
+    return success;
+}
+
+}  // namespace
+
+bool BenchmarkUnitColumns(int, char**) {
+    static const size_t unit_counts[] = {200, 1000, 3000};
+
+    bool success = true;
+    std::vector<UnitColumnsStats> results;
+    for (size_t unit_count : unit_counts) {
+        UnitColumnsStats stats;
+        success = RunUnitColumns(unit_count, stats) && success;
+        results.push_back(stats);
+    }
+
+    std::cout << std::endl;
+    std::cout << "Unit columns against a scan of the units, radius " << kTargetingRadius
+              << " and nearest enemy for every own unit (ms per step)" << std::endl;
+    std::cout << "------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "|" << std::setw(8) << std::left << "Units" << std::right << "|" << std::setw(10) << std::left
+              << "Assign" << std::right << "|" << std::setw(14) << std::left << "Range columns" << std::right << "|"
+              << std::setw(15) << std::left << "Range pointers" << std::right << "|" << std::setw(15) << std::left
+              << "Nearest columns" << std::right << "|" << std::setw(16) << std::left << "Nearest pointers"
+              << std::right << "|" << std::endl;
+    for (const UnitColumnsStats& stats : results) {
+        std::cout << "|" << std::setw(8) << std::left << stats.unit_count << std::right << "|" << std::setw(10)
+                  << std::left << stats.assign << std::right << "|" << std::setw(14) << std::left
+                  << stats.range_columns << std::right << "|" << std::setw(15) << std::left << stats.range_pointers
+                  << std::right << "|" << std::setw(15) << std::left << stats.nearest_columns << std::right << "|"
+                  << std::setw(16) << std::left << stats.nearest_pointers << std::right << "|" << std::endl;
+    }
+    std::cout << "------------------------------------------------------------------------------------" << std::endl;
+    std::cout << std::endl;
+
+    return success;
+}
+
+}  // namespace sc2
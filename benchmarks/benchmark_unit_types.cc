@@ -0,0 +1,144 @@
+#include "benchmark_unit_types.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "s2clientprotocol/sc2api.pb.h"
+#include "sc2api/sc2_api.h"
+#include "sc2api/sc2_unit_filters.h"
+#include "sc2fakeserver/sc2_fake_game.h"
+
+using namespace std::chrono;
+
+namespace sc2 {
+
+namespace {
+
+const int kIterations = 1000;
+
+class BenchmarkBot : public Agent {};
+
+// A query of the filter path and the same query through the type buckets. Both return a copy of the units, the way
+// GetUnits does, though a single type could be used by reference.
+struct TypeQuery {
+    std::string name;
+    std::function<Units(const ObservationInterface*)> filter;
+    std::function<Units(const ObservationInterface*)> buckets;
+};
+
+struct TypeQueryStats {
+    std::string name;
+    size_t matches;
+    double filter;
+    double buckets;
+};
+
+double TimeQuery(const std::function<Units(const ObservationInterface*)>& query, const ObservationInterface* obs,
+                 size_t& matches) {
+    matches = 0;
+    const high_resolution_clock::time_point start = high_resolution_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        matches += query(obs).size();
+    }
+    return duration_cast<duration<double>>(high_resolution_clock::now() - start).count() * 1e6 / kIterations;
+}
+
+}  // namespace
+
+bool BenchmarkUnitTypes(int, char**) {
+    // A late game frame of 600 units, own and enemy armies along with the mineral fields and geysers of the map.
+    FakeGameSettings settings;
+    settings.own_units = 280;
+    settings.enemy_units = 160;
+    settings.seed = 600;
+    FakeGame game(settings);
+
+    BenchmarkBot bot;
+    bot.Control()->Proto().SetRequestHandler(
+        [&game](const SC2APIProtocol::Request& request) { return game.Answer(request); });
+    if (!bot.Control()->GetObservation()) {
+        std::cerr << "Observing the late game frame failed." << std::endl;
+        return false;
+    }
+
+    const ObservationInterface* obs = bot.Observation();
+    const std::vector<TypeQuery> queries = {
+        {"SCVs",
+         [](const ObservationInterface* o) {
+             return o->GetUnits(Unit::Alliance::Self, IsUnit(UNIT_TYPEID::TERRAN_SCV));
+         },
+         [](const ObservationInterface* o) {
+             return o->GetUnitsOfType(Unit::Alliance::Self, UNIT_TYPEID::TERRAN_SCV);
+         }},
+        {"Marines, marauders",
+         [](const ObservationInterface* o) {
+             return o->GetUnits(Unit::Alliance::Self,
+                                IsUnits({UNIT_TYPEID::TERRAN_MARINE, UNIT_TYPEID::TERRAN_MARAUDER}));
+         },
+         [](const ObservationInterface* o) {
+             return o->GetUnitsOfType(Unit::Alliance::Self,
+                                      {UNIT_TYPEID::TERRAN_MARINE, UNIT_TYPEID::TERRAN_MARAUDER});
+         }},
+        {"Town halls",
+         [](const ObservationInterface* o) { return o->GetUnits(Unit::Alliance::Self, IsTownHall()); },
+         [](const ObservationInterface* o) { return o->GetUnitsOfType(Unit::Alliance::Self, IsTownHall()); }},
+        {"Geysers",
+         [](const ObservationInterface* o) { return o->GetUnits(Unit::Alliance::Neutral, IsGeyser()); },
+         [](const ObservationInterface* o) { return o->GetUnitsOfType(Unit::Alliance::Neutral, IsGeyser()); }},
+        {"Enemy roaches",
+         [](const ObservationInterface* o) {
+             return o->GetUnits(Unit::Alliance::Enemy, IsUnit(UNIT_TYPEID::ZERG_ROACH));
+         },
+         [](const ObservationInterface* o) {
+             return o->GetUnitsOfType(Unit::Alliance::Enemy, UNIT_TYPEID::ZERG_ROACH);
+         }},
+    };
+
+    bool success = obs->GetUnits().size() == 600;
+    std::vector<TypeQueryStats> results;
+    for (const TypeQuery& query : queries) {
+        // The buckets group the units by type, compare the units regardless of their order.
+        Units expected = query.filter(obs);
+        Units found = query.buckets(obs);
+        std::sort(expected.begin(), expected.end());
+        std::sort(found.begin(), found.end());
+        if (found != expected || found.empty()) {
+            std::cerr << "The type buckets don't find the units of the filter for " << query.name << "." << std::endl;
+            success = false;
+        }
+
+        TypeQueryStats stats;
+        stats.name = query.name;
+        size_t matches = 0;
+        stats.filter = TimeQuery(query.filter, obs, stats.matches);
+        stats.buckets = TimeQuery(query.buckets, obs, matches);
+        success = matches == stats.matches && success;
+        stats.matches /= kIterations;
+        results.push_back(stats);
+    }
+
+    std::cout << std::endl;
+    std::cout << "GetUnitsOfType against GetUnits with a filter, " << obs->GetUnits().size() << " units (us per call)"
+              << std::endl;
+    std::cout << "--------------------------------------------------------------" << std::endl;
+    std::cout << "|" << std::setw(20) << std::left << "Query" << std::right << "|" << std::setw(9) << std::left
+              << "Matches" << std::right << "|" << std::setw(14) << std::left << "Filter" << std::right << "|"
+              << std::setw(14) << std::left << "Buckets" << std::right << "|" << std::endl;
+    for (const TypeQueryStats& stats : results) {
+        std::cout << "|" << std::setw(20) << std::left << stats.name << std::right << "|" << std::setw(9)
+                  << std::left << stats.matches << std::right << "|" << std::setw(14) << std::left << stats.filter
+                  << std::right << "|" << std::setw(14) << std::left << stats.buckets << std::right << "|"
+                  << std::endl;
+    }
+    std::cout << "--------------------------------------------------------------" << std::endl;
+    std::cout << std::endl;
+
+    return success;
+}
+
+}  // namespace sc2
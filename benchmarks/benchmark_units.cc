@@ -0,0 +1,65 @@
+#include "benchmark_units.h"
+
+#include <limits>
+#include <random>
+
+namespace sc2 {
+
+namespace {
+
+const float kMapSize = 200.0F;
+
+}  // namespace
+
+BenchmarkUnits::BenchmarkUnits(size_t count) {
+    static const Unit::Alliance alliances[] = {Unit::Alliance::Self, Unit::Alliance::Enemy, Unit::Alliance::Neutral};
+
+    std::mt19937 generator(static_cast<std::mt19937::result_type>(count));
+    std::uniform_real_distribution<float> position(0.0F, kMapSize);
+
+    for (size_t i = 0; i < count; ++i) {
+        Unit* unit = unit_pool_.CreateUnit(i + 1);
+        unit->tag = i + 1;
+        unit->alliance = alliances[i % 3];
+        unit->pos = Point3D(position(generator), position(generator), 0.0F);
+        unit->health = 100.0F;
+        units_.push_back(unit);
+        if (unit->alliance == Unit::Alliance::Self) {
+            own_units_.push_back(unit);
+        }
+    }
+}
+
+void ScanUnitsInRange(const Units& units, const Point2D& center, float radius, Unit::Alliance alliance,
+                      Units& in_range) {
+    for (const Unit* unit : units) {
+        if (unit->alliance == alliance && DistanceSquared2D(center, unit->pos) <= radius * radius) {
+            in_range.push_back(unit);
+        }
+    }
+}
+
+const Unit* ScanNearestUnit(const Units& units, const Point2D& point, Unit::Alliance alliance) {
+    const Unit* nearest = nullptr;
+    float nearest_distance = std::numeric_limits<float>::infinity();
+    for (const Unit* unit : units) {
+        if (unit->alliance != alliance) {
+            continue;
+        }
+
+        const float distance = DistanceSquared2D(point, unit->pos);
+        if (distance < nearest_distance) {
+            nearest_distance = distance;
+            nearest = unit;
+        }
+    }
+
+    return nearest;
+}
+
+double StepMilliseconds(std::chrono::high_resolution_clock::time_point start) {
+    using namespace std::chrono;
+    return duration_cast<duration<double>>(high_resolution_clock::now() - start).count() * 1000.0 / kTargetingSteps;
+}
+
+}  // namespace sc2
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <chrono>
+
+#include "sc2api/sc2_unit.h"
+
+namespace sc2 {
+
+// The targeting workload of the spatial benchmarks: every own unit looks for enemies in range and for its nearest
+// enemy, the usual work of a bot each step.
+const float kTargetingRadius = 8.0F;
+const int kTargetingSteps = 10;
+
+// Units spread uniformly over a 200 by 200 map, alternating between own, enemy and neutral units. The same count gives
+// the same units.
+class BenchmarkUnits {
+public:
+    explicit BenchmarkUnits(size_t count);
+
+    BenchmarkUnits(const BenchmarkUnits&) = delete;
+    BenchmarkUnits& operator=(const BenchmarkUnits&) = delete;
+
+    const Units& GetUnits() const {
+        return units_;
+    }
+
+    const Units& GetOwnUnits() const {
+        return own_units_;
+    }
+
+private:
+    UnitPool unit_pool_;
+    Units units_;
+    Units own_units_;
+};
+
+// The units of an alliance within the radius, found by scanning all units. Distances are compared squared.
+void ScanUnitsInRange(const Units& units, const Point2D& center, float radius, Unit::Alliance alliance,
+                      Units& in_range);
+
+// The closest unit of an alliance, found by scanning all units. The first of equally distant units is returned.
+const Unit* ScanNearestUnit(const Units& units, const Point2D& point, Unit::Alliance alliance);
+
+// The time since start in milliseconds, divided by the steps of the workload. Summed over all steps, this is the
+// average per step.
+double StepMilliseconds(std::chrono::high_resolution_clock::time_point start);
+
+}  // namespace sc2
@@ -0,0 +1,95 @@
+// This example serves a fake game that answers clients like a running StarCraft II, from a capture or a synthetic game.
+// Bots attach to it the same way they attach to a running game, e.g. with Coordinator::Connect, so the client stack
+// can be load tested without a game binary.
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sc2fakeserver/sc2_fake_game_server.h"
+#include "sc2utils/sc2_arg_parser.h"
+#include "sc2utils/sc2_manage_process.h"
+
+int main(int argc, char* argv[]) {
+    sc2::ArgParser arg_parser(argv[0]);
+    arg_parser.AddOptions(
+        {{"-p", "--port", "The port of the first game to serve, 5679 by default.", false},
+         {"-n", "--count", "How many games to serve, on consecutive ports.", false},
+         {"-u", "--units", "Units of the observing player.", false},
+         {"-e", "--enemy_units", "Units of the enemy.", false},
+         {"-a", "--actions", "Raw actions reported in every observation.", false},
+         {"-g", "--game_loops", "Game loops until the game ends, 0 for a game that never ends.", false},
+         {"-l", "--latency", "Delay before answering each request, in microseconds.", false},
+         {"-c", "--capture", "Capture file to answer from instead of the synthetic game.", false}});
+
+    if (!arg_parser.Parse(argc, argv)) {
+        return 1;
+    }
+
+    sc2::FakeGameSettings settings;
+    std::string value;
+    int port = 5679;
+    int count = 1;
+    if (arg_parser.Get("port", value)) {
+        port = atoi(value.c_str());
+    }
+    if (arg_parser.Get("count", value)) {
+        count = atoi(value.c_str());
+    }
+    if (arg_parser.Get("units", value)) {
+        settings.own_units = atoi(value.c_str());
+    }
+    if (arg_parser.Get("enemy_units", value)) {
+        settings.enemy_units = atoi(value.c_str());
+    }
+    if (arg_parser.Get("actions", value)) {
+        settings.actions = atoi(value.c_str());
+    }
+    if (arg_parser.Get("game_loops", value)) {
+        settings.game_loops = static_cast<uint32_t>(atoi(value.c_str()));
+    }
+    if (arg_parser.Get("latency", value)) {
+        settings.latency_us = static_cast<unsigned int>(atoi(value.c_str()));
+    }
+
+    std::string capture;
+    arg_parser.Get("capture", capture);
+
+    // One game per port, the same way every client talks to a game process of its own.
+    std::vector<std::unique_ptr<sc2::FakeGameServer>> servers;
+    for (int i = 0; i < count; ++i) {
+        servers.push_back(std::make_unique<sc2::FakeGameServer>(settings));
+        sc2::FakeGameServer& server = *servers.back();
+        if (!capture.empty() && !server.Game().LoadCapture(capture)) {
+            std::cerr << "Failed to load the capture " << capture << std::endl;
+            return 1;
+        }
+
+        if (!server.Start(port + i)) {
+            std::cerr << "Failed to listen on port " << port + i << std::endl;
+            return 1;
+        }
+
+        std::cout << "Serving a fake game on port " << port + i << std::endl;
+    }
+
+    std::cout << "Press any key to stop." << std::endl;
+    uint64_t last_request_count = 0;
+    while (!sc2::PollKeyPress()) {
+        sc2::SleepFor(1000);
+
+        uint64_t request_count = 0;
+        for (const auto& server : servers) {
+            request_count += server->GetRequestCount();
+        }
+
+        if (request_count != last_request_count) {
+            std::cout << request_count - last_request_count << " requests/s" << std::endl;
+            last_request_count = request_count;
+        }
+    }
+
+    return 0;
+}
@@ -9,27 +9,22 @@ const int kFeatureLayerSize = 80;
 const int kPixelDrawSize = 5;
 const int kDrawSize = kFeatureLayerSize * kPixelDrawSize;
 
-void DrawFeatureLayer1BPP(const SC2APIProtocol::ImageData& image_data, int off_x, int off_y) {
-    assert(image_data.bits_per_pixel() == 1);
-    int width = image_data.size().x();
-    int height = image_data.size().y();
-    sc2::renderer::Matrix1BPP(image_data.data().c_str(), width, height, off_x, off_y, kPixelDrawSize, kPixelDrawSize);
+void DrawFeatureLayer1BPP(const sc2::ImageView& image, int off_x, int off_y) {
+    if (image.IsValid()) {
+        sc2::renderer::Matrix1BPP(image, off_x, off_y, kPixelDrawSize, kPixelDrawSize);
+    }
 }
 
-void DrawFeatureLayerUnits8BPP(const SC2APIProtocol::ImageData& image_data, int off_x, int off_y) {
-    assert(image_data.bits_per_pixel() == 8);
-    int width = image_data.size().x();
-    int height = image_data.size().y();
-    sc2::renderer::Matrix8BPPPlayers(image_data.data().c_str(), width, height, off_x, off_y, kPixelDrawSize,
-                                     kPixelDrawSize);
+void DrawFeatureLayerUnits8BPP(const sc2::ImageView& image, int off_x, int off_y) {
+    if (image.IsValid()) {
+        sc2::renderer::Matrix8BPPPlayers(image, off_x, off_y, kPixelDrawSize, kPixelDrawSize);
+    }
 }
 
-void DrawFeatureLayerHeightMap8BPP(const SC2APIProtocol::ImageData& image_data, int off_x, int off_y) {
-    assert(image_data.bits_per_pixel() == 8);
-    int width = image_data.size().x();
-    int height = image_data.size().y();
-    sc2::renderer::Matrix8BPPHeightMap(image_data.data().c_str(), width, height, off_x, off_y, kPixelDrawSize,
-                                       kPixelDrawSize);
+void DrawFeatureLayerHeightMap8BPP(const sc2::ImageView& image, int off_x, int off_y) {
+    if (image.IsValid()) {
+        sc2::renderer::Matrix8BPPHeightMap(image, off_x, off_y, kPixelDrawSize, kPixelDrawSize);
+    }
 }
 
 class RenderAgent : public sc2::Agent {
@@ -41,13 +36,14 @@ public:
     virtual void OnStep() final {
         const SC2APIProtocol::Observation* observation = Observation()->GetRawObservation();
 
+        // The layers are drawn straight from the observation, the pixels aren't copied.
         const SC2APIProtocol::FeatureLayers& m = observation->feature_layer_data().renders();
-        DrawFeatureLayerUnits8BPP(m.unit_density(), 0, 0);
-        DrawFeatureLayer1BPP(m.selected(), kDrawSize, 0);
+        DrawFeatureLayerUnits8BPP(Observation()->GetImageView(m.unit_density()), 0, 0);
+        DrawFeatureLayer1BPP(Observation()->GetImageView(m.selected()), kDrawSize, 0);
 
         const SC2APIProtocol::FeatureLayersMinimap& mi = observation->feature_layer_data().minimap_renders();
-        DrawFeatureLayerHeightMap8BPP(mi.height_map(), 0, kDrawSize);
-        DrawFeatureLayer1BPP(mi.camera(), kDrawSize, kDrawSize);
+        DrawFeatureLayerHeightMap8BPP(Observation()->GetImageView(mi.height_map()), 0, kDrawSize);
+        DrawFeatureLayer1BPP(Observation()->GetImageView(mi.camera()), kDrawSize, kDrawSize);
 
         sc2::renderer::Render();
     }
@@ -18,15 +18,14 @@ public:
     }
 
     virtual void OnStep() final {
-        const SC2APIProtocol::Observation* observation = Observation()->GetRawObservation();
-        const SC2APIProtocol::ObservationRender& render = observation->render_data();
-
-        const SC2APIProtocol::ImageData& minimap = render.minimap();
-        sc2::renderer::ImageRGB(&minimap.data().data()[0], minimap.size().x(), minimap.size().y(), 0,
-                                std::max(kMiniMapY, kMapY) - kMiniMapY);
+        // The frame is drawn straight from the observation, the pixels aren't copied.
+        const sc2::RenderedFrameView frame = Observation()->GetRenderedFrame();
+        if (!frame.map.IsValid() || !frame.minimap.IsValid()) {
+            return;
+        }
 
-        const SC2APIProtocol::ImageData& map = render.map();
-        sc2::renderer::ImageRGB(&map.data().data()[0], map.size().x(), map.size().y(), kMiniMapX, 0);
+        sc2::renderer::ImageRGB(frame.minimap, 0, std::max(kMiniMapY, kMapY) - kMiniMapY);
+        sc2::renderer::ImageRGB(frame.map, kMiniMapX, 0);
 
         sc2::renderer::Render();
     }
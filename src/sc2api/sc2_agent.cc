@@ -3,6 +3,7 @@
 #include "sc2_control_interfaces.h"
 #include "sc2_interfaces.h"
 #include "sc2_unit.h"
+#include "sc2utils/sc2_trace.h"
 
 namespace sc2 {
 
@@ -60,13 +61,16 @@ const Tags& ActionImp::Commands() const {
 }
 
 void ActionImp::SendActions() {
+    SC2_TRACE_SCOPE("ActionImp::SendActions");
     commands_.clear();
 
     if (request_actions_ == nullptr) {
         return;
     }
 
-    if (!proto_.SendRequest(request_actions_)) {
+    // When pipelining, the acknowledgment is consumed along with the next awaited response.
+    const bool await_response = !proto_.IsPipelining();
+    if (!proto_.SendRequest(request_actions_, false, await_response)) {
         return;
     }
 
@@ -81,7 +85,9 @@ void ActionImp::SendActions() {
     }
 
     request_actions_ = nullptr;
-    control_.WaitForResponse();
+    if (await_response) {
+        control_.WaitForResponse();
+    }
 }
 
 void ActionImp::ToggleAutocast(Tag unit_tag, AbilityID ability) {
@@ -273,16 +279,20 @@ SC2APIProtocol::RequestAction* ActionFeatureLayerImp::GetRequestAction() {
 }
 
 void ActionFeatureLayerImp::SendActions() {
+    SC2_TRACE_SCOPE("ActionFeatureLayerImp::SendActions");
     if (request_actions_ == nullptr) {
         return;
     }
 
-    if (!proto_.SendRequest(request_actions_)) {
+    const bool await_response = !proto_.IsPipelining();
+    if (!proto_.SendRequest(request_actions_, false, await_response)) {
         return;
     }
 
     request_actions_ = nullptr;
-    control_.WaitForResponse();
+    if (await_response) {
+        control_.WaitForResponse();
+    }
 }
 
 void ActionFeatureLayerImp::UnitCommand(AbilityID ability) {
@@ -393,6 +403,7 @@ bool AgentControlImp::Restart() {
         return false;
     }
 
+    agent_->Control()->ResetUnits();
     agent_->Control()->GetObservation();
     agent_->OnGameStart();
 
@@ -10,3 +10,4 @@
 #include "sc2_replay_observer.h"
 #include "sc2_typeenums.h"
 #include "sc2_unit.h"
+#include "sc2_unit_columns.h"
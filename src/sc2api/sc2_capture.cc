@@ -0,0 +1,253 @@
+#include "sc2_capture.h"
+
+#include <cstring>
+
+#include "s2clientprotocol/sc2api.pb.h"
+#include "sc2_proto_interface.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sc2 {
+
+namespace {
+
+// Identifies capture files, the last byte is the version of the format.
+const char kCaptureMagic[8] = {'S', 'C', '2', 'C', 'A', 'P', 'T', 1};
+
+}  // namespace
+
+const char* CaptureRecord::TypeName() const {
+    return RequestResponseIDToName(type);
+}
+
+bool CaptureRecord::Parse(SC2APIProtocol::Request& request) const {
+    return request.ParseFromArray(data, static_cast<int>(size));
+}
+
+bool CaptureRecord::Parse(SC2APIProtocol::Response& response) const {
+    return response.ParseFromArray(data, static_cast<int>(size));
+}
+
+CaptureWriter::CaptureWriter() : last_timestamp_ns_(0) {
+}
+
+CaptureWriter::~CaptureWriter() {
+    Close();
+}
+
+bool CaptureWriter::Open(const std::string& path) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (file_.is_open()) {
+        file_.close();
+    }
+
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) {
+        return false;
+    }
+
+    file_.write(kCaptureMagic, sizeof(kCaptureMagic));
+    start_ = std::chrono::steady_clock::now();
+    last_timestamp_ns_ = 0;
+    return file_.good();
+}
+
+void CaptureWriter::Close() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (file_.is_open()) {
+        file_.close();
+    }
+}
+
+bool CaptureWriter::IsOpen() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return file_.is_open();
+}
+
+void CaptureWriter::Write(CaptureDirection direction, int type, uint32_t id, const char* data, size_t size) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (!file_.is_open()) {
+        return;
+    }
+
+    // Timestamps are taken under the lock so records are in time order and the deltas are never negative.
+    const uint64_t timestamp_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count());
+
+    file_.put(static_cast<char>(direction));
+    WriteVarint(static_cast<uint64_t>(type));
+    WriteVarint(id);
+    WriteVarint(timestamp_ns - last_timestamp_ns_);
+    WriteVarint(size);
+    file_.write(data, static_cast<std::streamsize>(size));
+    last_timestamp_ns_ = timestamp_ns;
+}
+
+void CaptureWriter::WriteVarint(uint64_t value) {
+    char bytes[10];
+    size_t count = 0;
+    while (value >= 0x80) {
+        bytes[count++] = static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    bytes[count++] = static_cast<char>(value);
+    file_.write(bytes, static_cast<std::streamsize>(count));
+}
+
+CaptureReader::CaptureReader()
+    : data_(nullptr),
+      size_(0),
+      offset_(0),
+      timestamp_ns_(0)
+#if defined(_WIN32)
+      ,
+      file_(INVALID_HANDLE_VALUE),
+      mapping_(nullptr)
+#endif
+{
+}
+
+CaptureReader::~CaptureReader() {
+    Close();
+}
+
+bool CaptureReader::Open(const std::string& path) {
+    Close();
+
+#if defined(_WIN32)
+    file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                        nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_, &file_size) || file_size.QuadPart < static_cast<LONGLONG>(sizeof(kCaptureMagic))) {
+        Close();
+        return false;
+    }
+
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_) {
+        Close();
+        return false;
+    }
+
+    data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    size_ = static_cast<size_t>(file_size.QuadPart);
+#else
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(file, &file_stat) != 0 || file_stat.st_size < static_cast<off_t>(sizeof(kCaptureMagic))) {
+        close(file);
+        return false;
+    }
+
+    // The mapping stays valid after the descriptor is closed.
+    void* mapped = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+
+    // Records are read front to back.
+    madvise(mapped, static_cast<size_t>(file_stat.st_size), MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(mapped);
+    size_ = static_cast<size_t>(file_stat.st_size);
+#endif
+
+    if (!data_ || std::memcmp(data_, kCaptureMagic, sizeof(kCaptureMagic)) != 0) {
+        Close();
+        return false;
+    }
+
+    Rewind();
+    return true;
+}
+
+void CaptureReader::Close() {
+#if defined(_WIN32)
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+        mapping_ = nullptr;
+    }
+    if (file_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+
+    data_ = nullptr;
+    size_ = 0;
+    offset_ = 0;
+    timestamp_ns_ = 0;
+}
+
+bool CaptureReader::Next(CaptureRecord& record) {
+    if (!data_ || offset_ >= size_) {
+        return false;
+    }
+
+    const size_t start = offset_;
+    const uint8_t direction = static_cast<uint8_t>(data_[offset_++]);
+    uint64_t type = 0;
+    uint64_t id = 0;
+    uint64_t delta_ns = 0;
+    uint64_t size = 0;
+    if (direction > static_cast<uint8_t>(CaptureDirection::Response) || !ReadVarint(type) || !ReadVarint(id) ||
+        !ReadVarint(delta_ns) || !ReadVarint(size) || size > size_ - offset_) {
+        // A truncated record, e.g. the capture of a client that crashed.
+        offset_ = start;
+        return false;
+    }
+
+    timestamp_ns_ += delta_ns;
+
+    record.direction = static_cast<CaptureDirection>(direction);
+    record.type = static_cast<int>(type);
+    record.id = static_cast<uint32_t>(id);
+    record.timestamp_ns = timestamp_ns_;
+    record.data = data_ + offset_;
+    record.size = static_cast<size_t>(size);
+
+    offset_ += static_cast<size_t>(size);
+    return true;
+}
+
+void CaptureReader::Rewind() {
+    offset_ = data_ ? sizeof(kCaptureMagic) : 0;
+    timestamp_ns_ = 0;
+}
+
+bool CaptureReader::ReadVarint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && offset_ < size_; shift += 7) {
+        const uint8_t byte = static_cast<uint8_t>(data_[offset_++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+}  // namespace sc2
@@ -0,0 +1,134 @@
+/*! \file sc2_capture.h
+    \brief Recording of the protocol traffic between a client and the game.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+namespace SC2APIProtocol {
+class Request;
+class Response;
+}  // namespace SC2APIProtocol
+
+namespace sc2 {
+
+//! Direction of a captured message.
+enum class CaptureDirection {
+    Request = 0,   //!< Sent by the client.
+    Response = 1,  //!< Received from the game.
+};
+
+//! A message read back from a capture. The payload points into the mapped file and stays valid until the reader is
+//! closed.
+struct CaptureRecord {
+    CaptureDirection direction = CaptureDirection::Request;
+    //! The request or response case of the message, RequestResponseIDToName gives its name.
+    int type = 0;
+    //! The id of the request, or of the request answered. Zero if the message didn't carry one.
+    uint32_t id = 0;
+    //! Nanoseconds since the capture started, measured with a monotonic clock.
+    uint64_t timestamp_ns = 0;
+    const char* data = nullptr;
+    size_t size = 0;
+
+    //! Name of the request or response type of the message.
+    const char* TypeName() const;
+
+    //! Parses the payload of a request record.
+    //!< \param request The request to fill out.
+    //!< \return Returns true if the payload is a valid request.
+    bool Parse(SC2APIProtocol::Request& request) const;
+
+    //! Parses the payload of a response record.
+    //!< \param response The response to fill out.
+    //!< \return Returns true if the payload is a valid response.
+    bool Parse(SC2APIProtocol::Response& response) const;
+};
+
+//! Appends serialized messages to a capture file. A capture starts with a short header followed by one record per
+//! message: the direction, the type, the id, the time elapsed since the previous record and the payload size, all
+//! varint encoded, then the serialized message itself. Writing is thread safe, requests are written from the client
+//! thread and responses from the thread receiving them off the socket.
+class CaptureWriter {
+public:
+    CaptureWriter();
+    ~CaptureWriter();
+
+    //! Creates the capture file, replacing any existing file.
+    //!< \param path The path of the capture file.
+    //!< \return Returns true if the file could be created.
+    bool Open(const std::string& path);
+
+    //! Flushes and closes the capture file.
+    void Close();
+
+    //! Whether or not a capture file is open.
+    bool IsOpen() const;
+
+    //! Appends a message to the capture, timestamped with the current time.
+    //!< \param direction Whether the message was sent or received.
+    //!< \param type The request or response case of the message.
+    //!< \param id The id of the request.
+    //!< \param data The serialized message.
+    //!< \param size The size of the serialized message in bytes.
+    void Write(CaptureDirection direction, int type, uint32_t id, const char* data, size_t size);
+
+private:
+    void WriteVarint(uint64_t value);
+
+    mutable std::mutex mutex_;
+    std::ofstream file_;
+    std::chrono::steady_clock::time_point start_;
+    uint64_t last_timestamp_ns_;
+};
+
+//! Reads a capture file sequentially. The file is memory mapped so records are read without copying their payload and
+//! captures larger than memory can be streamed.
+class CaptureReader {
+public:
+    CaptureReader();
+    ~CaptureReader();
+
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+
+    //! Maps a capture file.
+    //!< \param path The path of the capture file.
+    //!< \return Returns true if the file could be mapped and has a valid header.
+    bool Open(const std::string& path);
+
+    //! Unmaps the capture file, invalidating the payloads of the records read so far.
+    void Close();
+
+    //! Reads the next record.
+    //!< \param record The record to fill out.
+    //!< \return Returns false at the end of the capture or if the record is truncated.
+    bool Next(CaptureRecord& record);
+
+    //! Starts reading again from the first record.
+    void Rewind();
+
+    //! Size of the mapped file in bytes.
+    size_t Size() const {
+        return size_;
+    }
+
+private:
+    bool ReadVarint(uint64_t& value);
+
+    const char* data_;
+    size_t size_;
+    size_t offset_;
+    uint64_t timestamp_ns_;
+#if defined(_WIN32)
+    void* file_;
+    void* mapping_;
+#endif
+};
+
+}  // namespace sc2
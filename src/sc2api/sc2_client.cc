@@ -14,59 +14,9 @@
 #include "sc2_interfaces.h"
 #include "sc2_proto_interface.h"
 #include "sc2_proto_to_pods.h"
+#include "sc2_unit_columns.h"
 #include "sc2utils/sc2_manage_process.h"
-
-namespace {
-
-struct MapState {
-    explicit MapState(const SC2APIProtocol::MapState& map);
-
-    bool HasCreep(const sc2::Point2D& point) const;
-
-    sc2::Visibility GetVisibility(const sc2::Point2D& point) const;
-
-private:
-    sc2::SampleImage creep_data_;
-    sc2::SampleImage visibility_data_;
-};
-
-MapState::MapState(const SC2APIProtocol::MapState& map) : creep_data_(map.creep()), visibility_data_(map.visibility()) {
-}
-
-bool MapState::HasCreep(const sc2::Point2D& point) const {
-    if (creep_data_.BPP() == 1) {
-        bool value;
-        if (!creep_data_.GetBit(point, &value))
-            return false;
-
-        return value;
-    }
-
-    unsigned char value;
-    if (!creep_data_.GetBit(point, &value))
-        return false;
-
-    return value > 0;
-}
-
-sc2::Visibility MapState::GetVisibility(const sc2::Point2D& point) const {
-    unsigned char value;
-    if (!visibility_data_.GetBit(point, &value))
-        return sc2::Visibility::FullHidden;
-
-    if (value == 0)
-        return sc2::Visibility::Hidden;
-
-    if (value == 1)
-        return sc2::Visibility::Fogged;
-
-    if (value == 2)
-        return sc2::Visibility::Visible;
-
-    return sc2::Visibility::FullHidden;
-}
-
-}  // namespace
+#include "sc2utils/sc2_trace.h"
 
 namespace sc2 {
 
@@ -94,9 +44,13 @@ public:
     std::vector<UpgradeID> upgrades_;
     std::vector<UpgradeID> upgrades_previous_;
     std::vector<ChatMessage> chat_;
+    MapState map_state_;
+    mutable UnitColumns unit_columns_;
+    mutable bool unit_columns_cached_ = false;
 
     // Game info.
     mutable GameInfo game_info_;
+    mutable StaticMapGrids static_map_grids_;
     mutable bool game_info_cached_;
     mutable bool use_generalized_ability_ = true;
 
@@ -145,8 +99,21 @@ public:
     }
     Units GetUnits() const final;
     Units GetUnits(Filter filter) const final;
-    Units GetUnits(Unit::Alliance alliance, Filter filter = {}) const final;
+    const Units& GetUnits(Unit::Alliance alliance) const final;
+    Units GetUnits(Unit::Alliance alliance, Filter filter) const final;
+    void GetUnits(Units& units, Filter filter = {}) const final;
+    void GetUnits(Units& units, Unit::Alliance alliance, Filter filter = {}) const final;
+    const Units& GetUnitsOfType(Unit::Alliance alliance, UnitTypeID type) const final;
+    Units GetUnitsOfType(Unit::Alliance alliance, const std::vector<UnitTypeID>& types) const final;
+    Units GetUnitsOfType(Unit::Alliance alliance, TypeFilter filter) const final;
     const Unit* GetUnit(Tag tag) const final;
+    const Units& GetChangedUnits() const final {
+        return unit_pool_.GetChangedUnits();
+    }
+    const UnitColumns& GetUnitColumns() const final;
+    uint32_t GetMaxUnitIndex() const final {
+        return unit_pool_.MaxIndex();
+    }
     const RawActions& GetRawActions() const final {
         return raw_actions_;
     }
@@ -178,10 +145,16 @@ public:
     const Effects& GetEffectData(bool force_refresh = false) const final;
     const GameInfo& GetGameInfo() const final;
     bool HasCreep(const Point2D& point) const final;
+    std::vector<bool> HasCreep(const std::vector<Point2D>& points) const final;
     Visibility GetVisibility(const Point2D& point) const final;
+    std::vector<Visibility> GetVisibility(const std::vector<Point2D>& points) const final;
+    const MapState& GetMapState() const final {
+        return map_state_;
+    }
     bool IsPathable(const Point2D& point) const final;
     bool IsPlacable(const Point2D& point) const final;
     float TerrainHeight(const Point2D& point) const final;
+    const StaticMapGrids& GetStaticMapGrids() const final;
 
     uint32_t GetMinerals() const final {
         return minerals_;
@@ -224,6 +197,8 @@ public:
     }
 
     const SC2APIProtocol::Observation* GetRawObservation() const final;
+    ImageView GetImageView(const SC2APIProtocol::ImageData& image) const final;
+    RenderedFrameView GetRenderedFrame() const final;
 
     bool UpdateObservation();
 };
@@ -250,8 +225,31 @@ void ObservationImp::ClearFlags() {
 }
 
 Units ObservationImp::GetUnits() const {
+    const std::vector<Unit*>& existing_units = unit_pool_.GetExistingUnits();
+    return Units(existing_units.begin(), existing_units.end());
+}
+
+const Units& ObservationImp::GetUnitsOfType(Unit::Alliance alliance, UnitTypeID type) const {
+    return unit_pool_.GetExistingUnits(alliance, type);
+}
+
+Units ObservationImp::GetUnitsOfType(Unit::Alliance alliance, const std::vector<UnitTypeID>& types) const {
+    Units units;
+    for (UnitTypeID type : types) {
+        const Units& units_of_type = unit_pool_.GetExistingUnits(alliance, type);
+        units.insert(units.end(), units_of_type.begin(), units_of_type.end());
+    }
+    return units;
+}
+
+Units ObservationImp::GetUnitsOfType(Unit::Alliance alliance, TypeFilter filter) const {
     Units units;
-    unit_pool_.ForEachExistingUnit([&](Unit& unit) { units.push_back(&unit); });
+    for (UnitTypeID type : unit_pool_.GetExistingUnitTypes(alliance)) {
+        if (filter(type)) {
+            const Units& units_of_type = unit_pool_.GetExistingUnits(alliance, type);
+            units.insert(units.end(), units_of_type.begin(), units_of_type.end());
+        }
+    }
     return units;
 }
 
@@ -259,28 +257,48 @@ const Unit* ObservationImp::GetUnit(Tag tag) const {
     return unit_pool_.GetExistingUnit(tag);
 }
 
+const Units& ObservationImp::GetUnits(Unit::Alliance alliance) const {
+    return unit_pool_.GetExistingUnits(alliance);
+}
+
 Units ObservationImp::GetUnits(Unit::Alliance alliance, Filter filter) const {
     Units units;
-    unit_pool_.ForEachExistingUnit([&](Unit& unit) {
-        if (unit.alliance != alliance) {
-            return;
-        }
-
-        if (!filter || filter(unit)) {
-            units.push_back(&unit);
-        }
-    });
+    GetUnits(units, alliance, filter);
     return units;
 }
 
 Units ObservationImp::GetUnits(Filter filter) const {
     Units units;
+    GetUnits(units, filter);
+    return units;
+}
+
+void ObservationImp::GetUnits(Units& units, Filter filter) const {
+    if (!filter) {
+        const std::vector<Unit*>& existing_units = unit_pool_.GetExistingUnits();
+        units.insert(units.end(), existing_units.begin(), existing_units.end());
+        return;
+    }
+
     unit_pool_.ForEachExistingUnit([&](Unit& unit) {
-        if (!filter || filter(unit)) {
+        if (filter(unit)) {
             units.push_back(&unit);
         }
     });
-    return units;
+}
+
+void ObservationImp::GetUnits(Units& units, Unit::Alliance alliance, Filter filter) const {
+    const Units& alliance_units = unit_pool_.GetExistingUnits(alliance);
+    if (!filter) {
+        units.insert(units.end(), alliance_units.begin(), alliance_units.end());
+        return;
+    }
+
+    for (const Unit* unit : alliance_units) {
+        if (filter(*unit)) {
+            units.push_back(unit);
+        }
+    }
 }
 
 const Abilities& ObservationImp::GetAbilityData(bool force_refresh) const {
@@ -502,6 +520,17 @@ const Effects& ObservationImp::GetEffectData(bool force_refresh) const {
     return effect_ids_;
 }
 
+const UnitColumns& ObservationImp::GetUnitColumns() const {
+    if (!unit_columns_cached_) {
+        SC2_TRACE_SCOPE("GetUnitColumns");
+        const std::vector<Unit*>& existing_units = unit_pool_.GetExistingUnits();
+        unit_columns_.Assign(Units(existing_units.begin(), existing_units.end()));
+        unit_columns_cached_ = true;
+    }
+
+    return unit_columns_;
+}
+
 const GameInfo& ObservationImp::GetGameInfo() const {
     if (game_info_cached_) {
         return game_info_;
@@ -522,44 +551,58 @@ const GameInfo& ObservationImp::GetGameInfo() const {
     }
 
     Convert(response_game_info, game_info_);
+    static_map_grids_ = StaticMapGrids(game_info_);
 
     game_info_cached_ = true;
     return game_info_;
 }
 
 bool ObservationImp::HasCreep(const Point2D& point) const {
-    ObservationRawPtr observation_raw;
-    SET_SUBMESSAGE_RESPONSE(observation_raw, observation_, raw_data);
-    if (observation_raw.HasErrors()) {
-        return false;
+    return map_state_.HasCreep(point);
+}
+
+std::vector<bool> ObservationImp::HasCreep(const std::vector<Point2D>& points) const {
+    std::vector<bool> creep(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        creep[i] = map_state_.HasCreep(points[i]);
     }
 
-    return MapState(observation_raw->map_state()).HasCreep(point);
+    return creep;
 }
 
 Visibility ObservationImp::GetVisibility(const Point2D& point) const {
-    ObservationRawPtr observation_raw;
-    SET_SUBMESSAGE_RESPONSE(observation_raw, observation_, raw_data);
-    if (observation_raw.HasErrors()) {
-        return Visibility::FullHidden;
+    return map_state_.GetVisibility(point);
+}
+
+std::vector<Visibility> ObservationImp::GetVisibility(const std::vector<Point2D>& points) const {
+    std::vector<Visibility> visibility(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        visibility[i] = map_state_.GetVisibility(points[i]);
     }
 
-    return MapState(observation_raw->map_state()).GetVisibility(point);
+    return visibility;
 }
 
 bool ObservationImp::IsPathable(const Point2D& point) const {
-    return PathingGrid(GetGameInfo()).IsPathable(point);
+    return GetStaticMapGrids().IsPathable(point);
 }
 
 bool ObservationImp::IsPlacable(const Point2D& point) const {
-    return PlacementGrid(GetGameInfo()).IsPlacable(point);
+    return GetStaticMapGrids().IsPlacable(point);
 }
 
 float ObservationImp::TerrainHeight(const Point2D& point) const {
-    return HeightMap(GetGameInfo()).TerrainHeight(point);
+    return GetStaticMapGrids().TerrainHeight(point);
+}
+
+const StaticMapGrids& ObservationImp::GetStaticMapGrids() const {
+    // The grids are built together with the cached game info.
+    GetGameInfo();
+    return static_map_grids_;
 }
 
 bool ObservationImp::UpdateObservation() {
+    SC2_TRACE_SCOPE("UpdateObservation");
     // Convert observation into data.
     if (!Convert(observation_, score_)) {
         return false;
@@ -623,17 +666,18 @@ bool ObservationImp::UpdateObservation() {
         return false;
     }
 
-    unit_pool_.ClearExisting();
-    Convert(observation_raw, unit_pool_, current_game_loop_, previous_game_loop);
+    {
+        SC2_TRACE_SCOPE("Convert");
+        Convert(observation_raw, map_state_);
 
-    // Remap ability ids in orders.
-    unit_pool_.ForEachExistingUnit([&](Unit& unit) {
-        for (UnitOrder& unit_order : unit.orders) {
-            if (use_generalized_ability_) {
-                unit_order.ability_id = GetGeneralizedAbilityID(unit_order.ability_id, *this);
-            }
-        }
-    });
+        unit_pool_.ReclaimDeadUnits(current_game_loop_);
+        unit_pool_.ClearExisting();
+        // Ability ids in orders are remapped while converting, so that changes of the orders are told apart.
+        Convert(observation_raw, unit_pool_, current_game_loop_, previous_game_loop,
+                use_generalized_ability_ ? this : nullptr);
+        unit_pool_.IndexExistingUnits();
+        unit_columns_cached_ = false;
+    }
 
     effects_.clear();
     effects_.resize(observation_raw->effects_size());
@@ -679,6 +723,21 @@ const SC2APIProtocol::Observation* ObservationImp::GetRawObservation() const {
     return observation_.get();
 }
 
+ImageView ObservationImp::GetImageView(const SC2APIProtocol::ImageData& image) const {
+    ImageView view;
+    Convert(image, observation_.GetResponse(), view);
+    return view;
+}
+
+RenderedFrameView ObservationImp::GetRenderedFrame() const {
+    RenderedFrameView frame;
+    if (!Convert(observation_, frame)) {
+        return RenderedFrameView();
+    }
+
+    return frame;
+}
+
 //-------------------------------------------------------------------------------------------------
 // QueryImp: An implementation of QueryInterface.
 //-------------------------------------------------------------------------------------------------
@@ -1362,7 +1421,9 @@ void DebugImp::SendDebug() {
     }
     endgame_victory_ = false;
 
-    proto_.SendRequest(request);
+    // When pipelining, the acknowledgments are consumed along with the next awaited response.
+    const bool await_response = !proto_.IsPipelining();
+    proto_.SendRequest(request, false, await_response);
     debug_text_.clear();
     debug_line_.clear();
     debug_box_.clear();
@@ -1374,7 +1435,9 @@ void DebugImp::SendDebug() {
     debug_unit_values_.clear();
 
     // Wait for the response.
-    control_.WaitForResponse();
+    if (await_response) {
+        control_.WaitForResponse();
+    }
 
     if (has_move_camera) {
         GameRequestPtr camera_request = proto_.MakeRequest();
@@ -1388,8 +1451,10 @@ void DebugImp::SendDebug() {
         point->set_y(debug_move_camera_.y);
 
         has_move_camera = false;
-        proto_.SendRequest(camera_request);
-        control_.WaitForResponse();
+        proto_.SendRequest(camera_request, false, await_response);
+        if (await_response) {
+            control_.WaitForResponse();
+        }
     }
 }
 
@@ -1440,6 +1505,7 @@ public:
 
     bool Step(int count = 1) override;
     bool WaitStep() override;
+    bool StepAndObserve(int count = 1) override;
 
     bool SaveReplay(const std::string& path) override;
 
@@ -1458,6 +1524,7 @@ public:
     bool HasResponsePending() const override;
 
     bool GetObservation() override;
+    bool WaitObservation();
     bool PollResponse() override;
     bool ConsumeResponse() override;
 
@@ -1497,6 +1564,14 @@ public:
         observation_imp_->use_generalized_ability_ = value;
     };
 
+    void SetDeadUnitRetention(uint32_t game_loops) override {
+        observation_imp_->unit_pool_.SetDeadUnitRetention(game_loops);
+    }
+    void ResetUnits() override;
+    UnitPoolReport GetUnitPoolReport() const override {
+        return observation_imp_->unit_pool_.GetReport();
+    }
+
     void Save() override;
     void Load() override;
 };
@@ -1785,8 +1860,10 @@ bool ControlImp::PollLeaveGame() {
     }
 
     if (proto_.GetResponsePending() != SC2APIProtocol::Response::kLeaveGame) {
-        // If not in a game, then it is in the end state trying to leave the game.
-        ErrorIf(HasResponsePending(), ClientError::ResponseNotConsumed);
+        // If not in a game, then it is in the end state trying to leave the game. Pipelined acknowledgments may
+        // still be pending, they are consumed with the next response.
+        ErrorIf(proto_.GetResponsePending() != SC2APIProtocol::Response::RESPONSE_NOT_SET,
+                ClientError::ResponseNotConsumed);
         return !IsInGame();
     }
 
@@ -1802,6 +1879,7 @@ bool ControlImp::PollLeaveGame() {
 }
 
 bool ControlImp::Step(int count) {
+    SC2_TRACE_SCOPE("ControlImp::Step");
     if (app_state_ != AppState::normal) {
         return false;
     }
@@ -1813,6 +1891,7 @@ bool ControlImp::Step(int count) {
 }
 
 bool ControlImp::WaitStep() {
+    SC2_TRACE_SCOPE("ControlImp::WaitStep");
     const GameResponsePtr response = WaitForResponse();
     if (!response.get() || !response->has_step() || response->error_size() > 0) {
         return false;
@@ -1821,6 +1900,38 @@ bool ControlImp::WaitStep() {
     return GetObservation();
 }
 
+bool ControlImp::StepAndObserve(int count) {
+    SC2_TRACE_SCOPE("ControlImp::StepAndObserve");
+    if (app_state_ != AppState::normal) {
+        return false;
+    }
+
+    GameRequestPtr request_step = proto_.MakeRequest();
+    request_step->mutable_step()->set_count(count);
+    if (!proto_.SendRequest(request_step)) {
+        return false;
+    }
+
+    // The observation is queued right behind the step, the game answers it as soon as the step is done.
+    GameRequestPtr request_observation = proto_.MakeRequest();
+    request_observation->mutable_observation();
+    const bool observation_sent = proto_.SendRequest(request_observation, true);
+
+    const GameResponsePtr response = WaitForResponse();
+    if (app_state_ != AppState::normal) {
+        // The game stopped responding while stepping, the observation queued behind the step won't be answered.
+        proto_.DiscardPendingResponses();
+        return false;
+    }
+    if (!response.get() || !observation_sent) {
+        return false;
+    }
+
+    // The observation has to be consumed even if the step failed.
+    const bool stepped = response->has_step() && response->error_size() == 0;
+    return WaitObservation() && stepped;
+}
+
 bool ControlImp::SaveReplay(const std::string& path) {
     GameRequestPtr request = proto_.MakeRequest();
     request->mutable_save_replay();
@@ -1854,6 +1965,7 @@ bool ControlImp::Ping() {
 }
 
 GameResponsePtr ControlImp::WaitForResponse() {
+    SC2_TRACE_SCOPE("ControlImp::WaitForResponse");
     assert(app_state_ == AppState::normal);
 
     GameResponsePtr response = proto_.WaitForResponseInternal();
@@ -1992,6 +2104,7 @@ bool ControlImp::HasResponsePending() const {
 }
 
 bool ControlImp::GetObservation() {
+    SC2_TRACE_SCOPE("ControlImp::GetObservation");
     if (app_state_ != AppState::normal) {
         return false;
     }
@@ -2002,6 +2115,10 @@ bool ControlImp::GetObservation() {
         return false;
     }
 
+    return WaitObservation();
+}
+
+bool ControlImp::WaitObservation() {
     const GameResponsePtr response = WaitForResponse();
     ResponseObservationPtr response_observation;
     SET_MESSAGE_RESPONSE(response_observation, response, observation);
@@ -2055,6 +2172,7 @@ bool ControlImp::WaitJoinGame() {
     }
 
     observation_imp_->player_id_ = response->join_game().player_id();
+    ResetUnits();
 
     std::cout << "WaitJoinGame finished successfully." << std::endl;
     return true;
@@ -2077,14 +2195,23 @@ void ControlImp::IssueUnitDestroyedEvents() {
     const SC2APIProtocol::ObservationRaw& raw = observation_->raw_data();
     if (raw.has_event()) {
         const SC2APIProtocol::Event& event = raw.event();
+        UnitPool& unit_pool = observation_imp_->unit_pool_;
+        for (const auto& tag : event.dead_units()) {
+            if (unit_pool.GetUnit(tag)) {
+                unit_pool.MarkDead(tag);
+                observation_imp_->unit_columns_cached_ = false;
+            }
+        }
+
+        // All units that died are gone from the existing units before the first event.
+        unit_pool.RemoveDeadExistingUnits();
         for (const auto& tag : event.dead_units()) {
-            const Unit* unit = observation_imp_->unit_pool_.GetUnit(tag);
+            const Unit* unit = unit_pool.GetUnit(tag);
 
             if (!unit) {
                 continue;
             }
 
-            observation_imp_->unit_pool_.MarkDead(tag);
             client_.OnUnitDestroyed(unit);
         }
     }
@@ -2181,16 +2308,41 @@ bool ControlImp::IssueEvents(const Tags& commands) {
         return false;
     }
 
-    IssueUnitDestroyedEvents();
-    IssueUnitAddedEvents();
-    IssueBuildingCompletedEvents();
-    IssueIdleEvents(commands);
-    IssueUpgradeEvents();
-    IssueAlertEvents();
-    IssueUnitDamagedEvents();
+    SC2_TRACE_SCOPE("ControlImp::IssueEvents");
+    {
+        SC2_TRACE_SCOPE("IssueUnitDestroyedEvents");
+        IssueUnitDestroyedEvents();
+    }
+    {
+        SC2_TRACE_SCOPE("IssueUnitAddedEvents");
+        IssueUnitAddedEvents();
+    }
+    {
+        SC2_TRACE_SCOPE("IssueBuildingCompletedEvents");
+        IssueBuildingCompletedEvents();
+    }
+    {
+        SC2_TRACE_SCOPE("IssueIdleEvents");
+        IssueIdleEvents(commands);
+    }
+    {
+        SC2_TRACE_SCOPE("IssueUpgradeEvents");
+        IssueUpgradeEvents();
+    }
+    {
+        SC2_TRACE_SCOPE("IssueAlertEvents");
+        IssueAlertEvents();
+    }
+    {
+        SC2_TRACE_SCOPE("IssueUnitDamagedEvents");
+        IssueUnitDamagedEvents();
+    }
 
     // Run the users OnStep function after events have been issued.
-    client_.OnStep();
+    {
+        SC2_TRACE_SCOPE("OnStep");
+        client_.OnStep();
+    }
 
     return true;
 }
@@ -2234,16 +2386,27 @@ void ControlImp::ErrorIf(bool condition, ClientError error, const std::vector<st
     }
 }
 
+void ControlImp::ResetUnits() {
+    observation_imp_->unit_pool_.Reset();
+    observation_imp_->unit_columns_.Clear();
+    observation_imp_->unit_columns_cached_ = false;
+}
+
 void ControlImp::DumpProtoUsage() {
-    const std::vector<uint32_t>& stats = proto_.GetStats();
+    const ProtoStats& stats = proto_.GetStats();
     std::cout << "******************************************************" << std::endl;
     std::cout << "Protocol use by message type:" << std::endl;
-    for (std::size_t i = 0; i < stats.size(); ++i) {
-        if (stats[i] == 0) {
+    for (std::size_t i = 0; i < stats.requests.size(); ++i) {
+        const RequestStats& request_stats = stats.requests[i];
+        if (request_stats.count == 0) {
             continue;
         }
 
-        std::cout << std::to_string(i) << ": " << std::to_string(stats[i]) << std::endl;
+        std::cout << RequestResponseIDToName(static_cast<int>(i)) << ": " << request_stats.count << " requests, "
+                  << request_stats.bytes_sent << " bytes sent, " << request_stats.bytes_received
+                  << " bytes received, latency p50/p99/max " << request_stats.latency_us.GetPercentile(50.0) << "/"
+                  << request_stats.latency_us.GetPercentile(99.0) << "/" << request_stats.latency_us.GetMax()
+                  << " us, parse p50 " << request_stats.parse_us.GetPercentile(50.0) << " us" << std::endl;
     }
 
     std::cout << "******************************************************" << std::endl;
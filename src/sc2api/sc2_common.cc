@@ -1,8 +1,16 @@
 #include "sc2_common.h"
 
+#include <atomic>
+#include <limits>
 #include <random>
 #include <thread>
 
+#include "sc2_simd.h"
+
+#if defined(SC2_SIMD_X86) && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
 // Avoiding use of "thread_local" as that isn't supported in older versions of Xcode.
 #if defined(__clang__) || defined(__GNUC__)
 #define TLS_OBJECT __thread
@@ -213,4 +221,536 @@ float Dot3D(const Point3D& a, const Point3D& b) {
     return a.x * b.x + a.y * b.y + a.z * b.z;
 }
 
+//
+// Batch geometry functions.
+//
+
+static_assert(sizeof(Point2D) == 2 * sizeof(float), "Arrays of Point2D are read as arrays of interleaved coordinates");
+
+namespace {
+
+// The points passed to a batch function, either an array of Point2D or arrays of coordinates.
+struct PointSet {
+    const Point2D* points;
+    const float* xs;
+    const float* ys;
+
+    Point2D Get(size_t i) const {
+        return points ? points[i] : Point2D(xs[i], ys[i]);
+    }
+};
+
+PointSet MakePointSet(const Point2D* points) {
+    return {points, nullptr, nullptr};
+}
+
+PointSet MakePointSet(const float* xs, const float* ys) {
+    return {nullptr, xs, ys};
+}
+
+SimdLevel DetectSimdLevel() {
+#if !defined(SC2_SIMD_X86)
+    return SimdLevel::Scalar;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return SimdLevel::SSE2;
+    }
+
+    // The operating system must save the AVX registers on context switches too.
+    __cpuid(info, 1);
+    const bool os_saves_avx = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return os_saves_avx && (info[1] & (1 << 5)) != 0 ? SimdLevel::AVX2 : SimdLevel::SSE2;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? SimdLevel::AVX2 : SimdLevel::SSE2;
+#endif
+}
+
+SimdLevel GetSupportedSimdLevel() {
+    static const SimdLevel supported = DetectSimdLevel();
+    return supported;
+}
+
+std::atomic<int>& GetSimdLevelState() {
+    static std::atomic<int> level(static_cast<int>(GetSupportedSimdLevel()));
+    return level;
+}
+
+// Every kernel below processes the points from begin on and returns the index of the first point it didn't process,
+// the scalar kernels finish the remaining points. Sums are split in 4 partial sums, of the points i % 4, which all
+// kernels accumulate in the same order.
+
+void DistancesScalar(const Point2D& point, const PointSet& set, size_t begin, size_t count, bool root,
+                     float* distances) {
+    for (size_t i = begin; i < count; ++i) {
+        const float distance = DistanceSquared2D(point, set.Get(i));
+        distances[i] = root ? std::sqrt(distance) : distance;
+    }
+}
+
+void ClosestScalar(const Point2D& point, const PointSet& set, size_t begin, size_t count, size_t& closest,
+                   float& closest_distance) {
+    for (size_t i = begin; i < count; ++i) {
+        const float distance = DistanceSquared2D(point, set.Get(i));
+        if (distance < closest_distance) {
+            closest_distance = distance;
+            closest = i;
+        }
+    }
+}
+
+void InRadiusScalar(const Point2D& center, float radius_squared, const PointSet& set, size_t begin, size_t count,
+                    std::vector<size_t>& indices) {
+    for (size_t i = begin; i < count; ++i) {
+        if (DistanceSquared2D(center, set.Get(i)) <= radius_squared) {
+            indices.push_back(i);
+        }
+    }
+}
+
+void SumScalar(const PointSet& set, size_t begin, size_t count, double sum_x[4], double sum_y[4]) {
+    for (size_t i = begin; i < count; ++i) {
+        const Point2D point = set.Get(i);
+        sum_x[i % 4] += point.x;
+        sum_y[i % 4] += point.y;
+    }
+}
+
+#if defined(SC2_SIMD_X86)
+
+void LoadSse2(const PointSet& set, size_t i, __m128& x, __m128& y) {
+    if (set.points) {
+        const float* coordinates = &set.points[i].x;
+        const __m128 a = _mm_loadu_ps(coordinates);
+        const __m128 b = _mm_loadu_ps(coordinates + 4);
+        x = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        y = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    } else {
+        x = _mm_loadu_ps(set.xs + i);
+        y = _mm_loadu_ps(set.ys + i);
+    }
+}
+
+// Same operations in the same order as DistanceSquared2D.
+__m128 DistanceSquaredSse2(__m128 point_x, __m128 point_y, __m128 x, __m128 y) {
+    const __m128 dx = _mm_sub_ps(point_x, x);
+    const __m128 dy = _mm_sub_ps(point_y, y);
+    return _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+}
+
+size_t DistancesSse2(const Point2D& point, const PointSet& set, size_t count, bool root, float* distances) {
+    const __m128 point_x = _mm_set1_ps(point.x);
+    const __m128 point_y = _mm_set1_ps(point.y);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x, y;
+        LoadSse2(set, i, x, y);
+        __m128 distance = DistanceSquaredSse2(point_x, point_y, x, y);
+        if (root) {
+            distance = _mm_sqrt_ps(distance);
+        }
+        _mm_storeu_ps(distances + i, distance);
+    }
+
+    return i;
+}
+
+size_t ClosestSse2(const Point2D& point, const PointSet& set, size_t count, size_t& closest,
+                   float& closest_distance) {
+    const __m128 point_x = _mm_set1_ps(point.x);
+    const __m128 point_y = _mm_set1_ps(point.y);
+
+    // Every lane keeps the first closest point it has seen.
+    __m128 best_distance = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    __m128i best_index = _mm_set1_epi32(-1);
+    __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i step = _mm_set1_epi32(4);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x, y;
+        LoadSse2(set, i, x, y);
+        const __m128 distance = DistanceSquaredSse2(point_x, point_y, x, y);
+        const __m128 closer = _mm_cmplt_ps(distance, best_distance);
+        const __m128i closer_mask = _mm_castps_si128(closer);
+        best_distance = _mm_or_ps(_mm_and_ps(closer, distance), _mm_andnot_ps(closer, best_distance));
+        best_index = _mm_or_si128(_mm_and_si128(closer_mask, index), _mm_andnot_si128(closer_mask, best_index));
+        index = _mm_add_epi32(index, step);
+    }
+
+    alignas(16) float distances[4];
+    alignas(16) int32_t indices[4];
+    _mm_store_ps(distances, best_distance);
+    _mm_store_si128(reinterpret_cast<__m128i*>(indices), best_index);
+
+    // Of equally distant points the first one wins, as with a scan in order.
+    for (int lane = 0; lane < 4; ++lane) {
+        if (indices[lane] < 0) {
+            continue;
+        }
+        if (distances[lane] < closest_distance ||
+            (distances[lane] == closest_distance && static_cast<size_t>(indices[lane]) < closest)) {
+            closest_distance = distances[lane];
+            closest = static_cast<size_t>(indices[lane]);
+        }
+    }
+
+    return i;
+}
+
+size_t InRadiusSse2(const Point2D& center, float radius_squared, const PointSet& set, size_t count,
+                    std::vector<size_t>& indices) {
+    const __m128 center_x = _mm_set1_ps(center.x);
+    const __m128 center_y = _mm_set1_ps(center.y);
+    const __m128 range = _mm_set1_ps(radius_squared);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x, y;
+        LoadSse2(set, i, x, y);
+        const __m128 in_range = _mm_cmple_ps(DistanceSquaredSse2(center_x, center_y, x, y), range);
+        for (int mask = _mm_movemask_ps(in_range), lane = 0; mask; mask >>= 1, ++lane) {
+            if (mask & 1) {
+                indices.push_back(i + lane);
+            }
+        }
+    }
+
+    return i;
+}
+
+size_t SumSse2(const PointSet& set, size_t count, double sum_x[4], double sum_y[4]) {
+    size_t i = 0;
+    if (set.points) {
+        // One accumulator of (x, y) per partial sum.
+        __m128d sums[4] = {_mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd()};
+        for (; i + 4 <= count; i += 4) {
+            const float* coordinates = &set.points[i].x;
+            const __m128 a = _mm_loadu_ps(coordinates);
+            const __m128 b = _mm_loadu_ps(coordinates + 4);
+            sums[0] = _mm_add_pd(sums[0], _mm_cvtps_pd(a));
+            sums[1] = _mm_add_pd(sums[1], _mm_cvtps_pd(_mm_movehl_ps(a, a)));
+            sums[2] = _mm_add_pd(sums[2], _mm_cvtps_pd(b));
+            sums[3] = _mm_add_pd(sums[3], _mm_cvtps_pd(_mm_movehl_ps(b, b)));
+        }
+
+        for (int j = 0; j < 4; ++j) {
+            alignas(16) double sum[2];
+            _mm_store_pd(sum, sums[j]);
+            sum_x[j] = sum[0];
+            sum_y[j] = sum[1];
+        }
+    } else {
+        // Partial sums 0 and 1, 2 and 3 of each coordinate.
+        __m128d sums_x[2] = {_mm_setzero_pd(), _mm_setzero_pd()};
+        __m128d sums_y[2] = {_mm_setzero_pd(), _mm_setzero_pd()};
+        for (; i + 4 <= count; i += 4) {
+            const __m128 x = _mm_loadu_ps(set.xs + i);
+            const __m128 y = _mm_loadu_ps(set.ys + i);
+            sums_x[0] = _mm_add_pd(sums_x[0], _mm_cvtps_pd(x));
+            sums_x[1] = _mm_add_pd(sums_x[1], _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+            sums_y[0] = _mm_add_pd(sums_y[0], _mm_cvtps_pd(y));
+            sums_y[1] = _mm_add_pd(sums_y[1], _mm_cvtps_pd(_mm_movehl_ps(y, y)));
+        }
+
+        _mm_storeu_pd(sum_x, sums_x[0]);
+        _mm_storeu_pd(sum_x + 2, sums_x[1]);
+        _mm_storeu_pd(sum_y, sums_y[0]);
+        _mm_storeu_pd(sum_y + 2, sums_y[1]);
+    }
+
+    return i;
+}
+
+SC2_TARGET_AVX2 void LoadAvx2(const PointSet& set, size_t i, __m256& x, __m256& y) {
+    if (set.points) {
+        // The shuffles leave the coordinates of points 0 1 4 5 2 3 6 7, the permutation puts them back in order.
+        const float* coordinates = &set.points[i].x;
+        const __m256 a = _mm256_loadu_ps(coordinates);
+        const __m256 b = _mm256_loadu_ps(coordinates + 8);
+        const __m256 shuffled_x = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m256 shuffled_y = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        x = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(shuffled_x), _MM_SHUFFLE(3, 1, 2, 0)));
+        y = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(shuffled_y), _MM_SHUFFLE(3, 1, 2, 0)));
+    } else {
+        x = _mm256_loadu_ps(set.xs + i);
+        y = _mm256_loadu_ps(set.ys + i);
+    }
+}
+
+SC2_TARGET_AVX2 __m256 DistanceSquaredAvx2(__m256 point_x, __m256 point_y, __m256 x, __m256 y) {
+    const __m256 dx = _mm256_sub_ps(point_x, x);
+    const __m256 dy = _mm256_sub_ps(point_y, y);
+    return _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+}
+
+SC2_TARGET_AVX2 size_t DistancesAvx2(const Point2D& point, const PointSet& set, size_t count, bool root,
+                                     float* distances) {
+    const __m256 point_x = _mm256_set1_ps(point.x);
+    const __m256 point_y = _mm256_set1_ps(point.y);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x, y;
+        LoadAvx2(set, i, x, y);
+        __m256 distance = DistanceSquaredAvx2(point_x, point_y, x, y);
+        if (root) {
+            distance = _mm256_sqrt_ps(distance);
+        }
+        _mm256_storeu_ps(distances + i, distance);
+    }
+
+    return i;
+}
+
+SC2_TARGET_AVX2 size_t ClosestAvx2(const Point2D& point, const PointSet& set, size_t count, size_t& closest,
+                                   float& closest_distance) {
+    const __m256 point_x = _mm256_set1_ps(point.x);
+    const __m256 point_y = _mm256_set1_ps(point.y);
+
+    // Every lane keeps the first closest point it has seen.
+    __m256 best_distance = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+    __m256i best_index = _mm256_set1_epi32(-1);
+    __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i step = _mm256_set1_epi32(8);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x, y;
+        LoadAvx2(set, i, x, y);
+        const __m256 distance = DistanceSquaredAvx2(point_x, point_y, x, y);
+        const __m256 closer = _mm256_cmp_ps(distance, best_distance, _CMP_LT_OQ);
+        best_distance = _mm256_blendv_ps(best_distance, distance, closer);
+        best_index = _mm256_blendv_epi8(best_index, index, _mm256_castps_si256(closer));
+        index = _mm256_add_epi32(index, step);
+    }
+
+    alignas(32) float distances[8];
+    alignas(32) int32_t indices[8];
+    _mm256_store_ps(distances, best_distance);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(indices), best_index);
+
+    // Of equally distant points the first one wins, as with a scan in order.
+    for (int lane = 0; lane < 8; ++lane) {
+        if (indices[lane] < 0) {
+            continue;
+        }
+        if (distances[lane] < closest_distance ||
+            (distances[lane] == closest_distance && static_cast<size_t>(indices[lane]) < closest)) {
+            closest_distance = distances[lane];
+            closest = static_cast<size_t>(indices[lane]);
+        }
+    }
+
+    return i;
+}
+
+SC2_TARGET_AVX2 size_t InRadiusAvx2(const Point2D& center, float radius_squared, const PointSet& set, size_t count,
+                                    std::vector<size_t>& indices) {
+    const __m256 center_x = _mm256_set1_ps(center.x);
+    const __m256 center_y = _mm256_set1_ps(center.y);
+    const __m256 range = _mm256_set1_ps(radius_squared);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x, y;
+        LoadAvx2(set, i, x, y);
+        const __m256 in_range = _mm256_cmp_ps(DistanceSquaredAvx2(center_x, center_y, x, y), range, _CMP_LE_OQ);
+        for (int mask = _mm256_movemask_ps(in_range), lane = 0; mask; mask >>= 1, ++lane) {
+            if (mask & 1) {
+                indices.push_back(i + lane);
+            }
+        }
+    }
+
+    return i;
+}
+
+SC2_TARGET_AVX2 size_t SumAvx2(const PointSet& set, size_t count, double sum_x[4], double sum_y[4]) {
+    size_t i = 0;
+    if (set.points) {
+        // Accumulators of (x, y) of partial sums 0 and 1, 2 and 3.
+        __m256d sums[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+        for (; i + 4 <= count; i += 4) {
+            const __m256 coordinates = _mm256_loadu_ps(&set.points[i].x);
+            sums[0] = _mm256_add_pd(sums[0], _mm256_cvtps_pd(_mm256_castps256_ps128(coordinates)));
+            sums[1] = _mm256_add_pd(sums[1], _mm256_cvtps_pd(_mm256_extractf128_ps(coordinates, 1)));
+        }
+
+        for (int j = 0; j < 2; ++j) {
+            alignas(32) double sum[4];
+            _mm256_store_pd(sum, sums[j]);
+            sum_x[2 * j] = sum[0];
+            sum_y[2 * j] = sum[1];
+            sum_x[2 * j + 1] = sum[2];
+            sum_y[2 * j + 1] = sum[3];
+        }
+    } else {
+        __m256d sums_x = _mm256_setzero_pd();
+        __m256d sums_y = _mm256_setzero_pd();
+        for (; i + 4 <= count; i += 4) {
+            sums_x = _mm256_add_pd(sums_x, _mm256_cvtps_pd(_mm_loadu_ps(set.xs + i)));
+            sums_y = _mm256_add_pd(sums_y, _mm256_cvtps_pd(_mm_loadu_ps(set.ys + i)));
+        }
+
+        _mm256_storeu_pd(sum_x, sums_x);
+        _mm256_storeu_pd(sum_y, sums_y);
+    }
+
+    return i;
+}
+
+#endif
+
+void Distances(const Point2D& point, const PointSet& set, size_t count, bool root, float* distances) {
+    size_t begin = 0;
+#if defined(SC2_SIMD_X86)
+    switch (GetSimdLevel()) {
+        case SimdLevel::AVX2:
+            begin = DistancesAvx2(point, set, count, root, distances);
+            break;
+        case SimdLevel::SSE2:
+            begin = DistancesSse2(point, set, count, root, distances);
+            break;
+        default:
+            break;
+    }
+#endif
+    DistancesScalar(point, set, begin, count, root, distances);
+}
+
+size_t Closest(const Point2D& point, const PointSet& set, size_t count, float* distance_squared) {
+    size_t closest = count;
+    float closest_distance = std::numeric_limits<float>::infinity();
+    size_t begin = 0;
+#if defined(SC2_SIMD_X86)
+    switch (GetSimdLevel()) {
+        case SimdLevel::AVX2:
+            begin = ClosestAvx2(point, set, count, closest, closest_distance);
+            break;
+        case SimdLevel::SSE2:
+            begin = ClosestSse2(point, set, count, closest, closest_distance);
+            break;
+        default:
+            break;
+    }
+#endif
+    ClosestScalar(point, set, begin, count, closest, closest_distance);
+
+    if (distance_squared) {
+        *distance_squared = closest_distance;
+    }
+    return closest;
+}
+
+void InRadius(const Point2D& center, float radius, const PointSet& set, size_t count, std::vector<size_t>& indices) {
+    const float radius_squared = radius * radius;
+    size_t begin = 0;
+#if defined(SC2_SIMD_X86)
+    switch (GetSimdLevel()) {
+        case SimdLevel::AVX2:
+            begin = InRadiusAvx2(center, radius_squared, set, count, indices);
+            break;
+        case SimdLevel::SSE2:
+            begin = InRadiusSse2(center, radius_squared, set, count, indices);
+            break;
+        default:
+            break;
+    }
+#endif
+    InRadiusScalar(center, radius_squared, set, begin, count, indices);
+}
+
+Point2D Centroid(const PointSet& set, size_t count) {
+    if (count == 0) {
+        return Point2D();
+    }
+
+    double sum_x[4] = {0.0, 0.0, 0.0, 0.0};
+    double sum_y[4] = {0.0, 0.0, 0.0, 0.0};
+    size_t begin = 0;
+#if defined(SC2_SIMD_X86)
+    switch (GetSimdLevel()) {
+        case SimdLevel::AVX2:
+            begin = SumAvx2(set, count, sum_x, sum_y);
+            break;
+        case SimdLevel::SSE2:
+            begin = SumSse2(set, count, sum_x, sum_y);
+            break;
+        default:
+            break;
+    }
+#endif
+    SumScalar(set, begin, count, sum_x, sum_y);
+
+    const double total_x = (sum_x[0] + sum_x[1]) + (sum_x[2] + sum_x[3]);
+    const double total_y = (sum_y[0] + sum_y[1]) + (sum_y[2] + sum_y[3]);
+    return Point2D(static_cast<float>(total_x / count), static_cast<float>(total_y / count));
+}
+
+}  // namespace
+
+SimdLevel GetSimdLevel() {
+    return static_cast<SimdLevel>(GetSimdLevelState().load(std::memory_order_relaxed));
+}
+
+SimdLevel SetSimdLevel(SimdLevel level) {
+    const SimdLevel used = std::min(level, GetSupportedSimdLevel());
+    GetSimdLevelState().store(static_cast<int>(used), std::memory_order_relaxed);
+    return used;
+}
+
+void Distances2D(const Point2D& point, const Point2D* points, size_t count, float* distances) {
+    Distances(point, MakePointSet(points), count, true, distances);
+}
+
+void Distances2D(const Point2D& point, const float* xs, const float* ys, size_t count, float* distances) {
+    Distances(point, MakePointSet(xs, ys), count, true, distances);
+}
+
+void DistancesSquared2D(const Point2D& point, const Point2D* points, size_t count, float* distances) {
+    Distances(point, MakePointSet(points), count, false, distances);
+}
+
+void DistancesSquared2D(const Point2D& point, const float* xs, const float* ys, size_t count, float* distances) {
+    Distances(point, MakePointSet(xs, ys), count, false, distances);
+}
+
+size_t ClosestPoint2D(const Point2D& point, const Point2D* points, size_t count, float* distance_squared) {
+    return Closest(point, MakePointSet(points), count, distance_squared);
+}
+
+size_t ClosestPoint2D(const Point2D& point, const float* xs, const float* ys, size_t count, float* distance_squared) {
+    return Closest(point, MakePointSet(xs, ys), count, distance_squared);
+}
+
+void PointsInRadius2D(const Point2D& center, float radius, const Point2D* points, size_t count,
+                      std::vector<size_t>& indices) {
+    InRadius(center, radius, MakePointSet(points), count, indices);
+}
+
+void PointsInRadius2D(const Point2D& center, float radius, const float* xs, const float* ys, size_t count,
+                      std::vector<size_t>& indices) {
+    InRadius(center, radius, MakePointSet(xs, ys), count, indices);
+}
+
+void DistanceMatrix2D(const Point2D* a, size_t count_a, const Point2D* b, size_t count_b, float* distances) {
+    const PointSet set = MakePointSet(b);
+    for (size_t i = 0; i < count_a; ++i) {
+        Distances(a[i], set, count_b, true, distances + i * count_b);
+    }
+}
+
+Point2D Centroid2D(const Point2D* points, size_t count) {
+    return Centroid(MakePointSet(points), count);
+}
+
+Point2D Centroid2D(const float* xs, const float* ys, size_t count) {
+    return Centroid(MakePointSet(xs, ys), count);
+}
+
 }  // namespace sc2
@@ -5,7 +5,9 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
+#include <vector>
 
 namespace sc2 {
 
@@ -199,4 +201,74 @@ void Normalize3D(Point3D& a);
 //!< \return Dot product.
 float Dot3D(const Point3D& a, const Point3D& b);
 
+//! Instruction sets the batch geometry functions below can run with.
+enum class SimdLevel {
+    //! Plain loops.
+    Scalar = 0,
+    //! 4 points at a time.
+    SSE2 = 1,
+    //! 8 points at a time.
+    AVX2 = 2,
+};
+
+//! The instruction set the batch geometry functions run with, by default the best one the processor supports.
+//!< \return The instruction set.
+SimdLevel GetSimdLevel();
+//! Overrides the instruction set the batch geometry functions run with, e.g. to compare them. All of them give the
+//! same results.
+//!< \param level The instruction set, lowered to the best one the processor supports.
+//!< \return The instruction set actually used.
+SimdLevel SetSimdLevel(SimdLevel level);
+
+// The batch functions below give exactly the results of calling the single point functions above in a loop, whatever
+// the instruction set. Points are passed either as an array of Point2D or as separate arrays of x and y coordinates.
+
+//! The distances from a point to many points.
+//!< \param point The point to measure the distances from.
+//!< \param points The points to measure the distances to.
+//!< \param count The number of points.
+//!< \param distances Receives the count distances, distances[i] == Distance2D(point, points[i]).
+void Distances2D(const Point2D& point, const Point2D* points, size_t count, float* distances);
+void Distances2D(const Point2D& point, const float* xs, const float* ys, size_t count, float* distances);
+//! The squared distances from a point to many points.
+//!< \param point The point to measure the distances from.
+//!< \param points The points to measure the distances to.
+//!< \param count The number of points.
+//!< \param distances Receives the count squared distances, distances[i] == DistanceSquared2D(point, points[i]).
+void DistancesSquared2D(const Point2D& point, const Point2D* points, size_t count, float* distances);
+void DistancesSquared2D(const Point2D& point, const float* xs, const float* ys, size_t count, float* distances);
+//! The closest of many points to a point, the first one of equally distant points.
+//!< \param point The point to measure the distances from.
+//!< \param points The points to search.
+//!< \param count The number of points.
+//!< \param distance_squared If not null, receives the squared distance to the closest point.
+//!< \return The index of the closest point, count if no point is at a finite distance, e.g. if count is 0.
+size_t ClosestPoint2D(const Point2D& point, const Point2D* points, size_t count, float* distance_squared = nullptr);
+size_t ClosestPoint2D(const Point2D& point, const float* xs, const float* ys, size_t count,
+                      float* distance_squared = nullptr);
+//! The points within radius of a center, DistanceSquared2D(center, points[i]) <= radius * radius.
+//!< \param center The center of the circle.
+//!< \param radius The radius of the circle.
+//!< \param points The points to search.
+//!< \param count The number of points.
+//!< \param indices Receives the indices of the points in the circle, in increasing order. Appended to, not cleared.
+void PointsInRadius2D(const Point2D& center, float radius, const Point2D* points, size_t count,
+                      std::vector<size_t>& indices);
+void PointsInRadius2D(const Point2D& center, float radius, const float* xs, const float* ys, size_t count,
+                      std::vector<size_t>& indices);
+//! The distances between every point of a set and every point of another set.
+//!< \param a The first set of points.
+//!< \param count_a The number of points of the first set.
+//!< \param b The second set of points.
+//!< \param count_b The number of points of the second set.
+//!< \param distances Receives count_a rows of count_b distances, distances[i * count_b + j] == Distance2D(a[i], b[j]).
+void DistanceMatrix2D(const Point2D* a, size_t count_a, const Point2D* b, size_t count_b, float* distances);
+//! The average of many points. The coordinates are summed in double precision, in the same order whatever the
+//! instruction set, so the result doesn't depend on it.
+//!< \param points The points to average.
+//!< \param count The number of points.
+//!< \return The average, (0, 0) if count is 0.
+Point2D Centroid2D(const Point2D* points, size_t count);
+Point2D Centroid2D(const float* xs, const float* ys, size_t count);
+
 }  // namespace sc2
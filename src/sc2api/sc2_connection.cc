@@ -1,5 +1,8 @@
 #include "sc2_connection.h"
 
+#include <google/protobuf/arena.h>
+
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <iostream>
@@ -43,6 +46,86 @@ bool StartCivetweb() {
 
 namespace sc2 {
 
+// Arenas handed out for parsing responses. Every arena starts with a block of memory owned by the pool that survives
+// resets, and the block grows to fit the largest response parsed so far. Once warm, parsing a response allocates
+// nothing but the arena bookkeeping. Arenas are acquired on the civetweb thread and released on whichever thread drops
+// the last reference to the response.
+class ResponseArenaPool {
+public:
+    google::protobuf::Arena* Acquire() {
+        std::lock_guard<std::mutex> guard(mutex_);
+        for (const std::unique_ptr<Entry>& entry : entries_) {
+            if (!entry->in_use) {
+                entry->in_use = true;
+                return entry->arena.get();
+            }
+        }
+
+        entries_.push_back(std::make_unique<Entry>());
+        Entry& entry = *entries_.back();
+        entry.block.resize(kInitialBlockSize);
+        entry.arena = CreateArena(entry.block);
+        entry.in_use = true;
+        return entry.arena.get();
+    }
+
+    void Release(google::protobuf::Arena* arena) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        for (const std::unique_ptr<Entry>& entry : entries_) {
+            if (entry->arena.get() != arena) {
+                continue;
+            }
+
+            // Blocks allocated beyond the initial one are freed on reset, so fold them into a bigger initial block. The
+            // growth is based on the space used, the space allocated includes a small block for every other thread that
+            // allocated from the arena and would grow the initial block on every release.
+            const size_t space_used = static_cast<size_t>(arena->SpaceUsed());
+            if (space_used > entry->block.size()) {
+                entry->arena.reset();
+                entry->block.resize(space_used + space_used / 4);
+                entry->arena = CreateArena(entry->block);
+            } else {
+                arena->Reset();
+            }
+
+            entry->in_use = false;
+            return;
+        }
+
+        assert(false && "Released an arena that doesn't belong to the pool.");
+    }
+
+private:
+    static const size_t kInitialBlockSize = 64 * 1024;
+
+    struct Entry {
+        std::vector<char> block;
+        std::unique_ptr<google::protobuf::Arena> arena;
+        bool in_use = false;
+    };
+
+    static std::unique_ptr<google::protobuf::Arena> CreateArena(std::vector<char>& block) {
+        google::protobuf::ArenaOptions options;
+        options.initial_block = block.data();
+        options.initial_block_size = block.size();
+        return std::make_unique<google::protobuf::Arena>(options);
+    }
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Entry>> entries_;
+};
+
+size_t SerializeToBuffer(const google::protobuf::MessageLite& message, std::vector<char>& buffer) {
+    const size_t size = message.ByteSizeLong();
+    if (buffer.size() < size) {
+        buffer.resize(size);
+    }
+
+    // ByteSizeLong caches the sizes of all submessages, no need to compute them again.
+    message.SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t*>(buffer.data()));
+    return size;
+}
+
 bool GetClientData(const mg_connection* connection, sc2::Connection*& out) {
     if (!connection) {
         return false;
@@ -64,14 +147,26 @@ static int DataHandler(mg_connection* conn, int /*flags*/, char* data, size_t da
         return 0;
     }
 
-    SC2APIProtocol::Response* response = new SC2APIProtocol::Response();
-    if (!response->ParseFromArray(data, (int)data_len)) {
+    sc2::ResponseInfo info;
+    info.bytes = data_len;
+    info.received = std::chrono::steady_clock::now();
+
+    SC2APIProtocol::Response* response = sc2_connection->CreateResponse();
+    const bool parsed = response->ParseFromArray(data, (int)data_len);
+    info.parse_us = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - info.received)
+            .count());
+    if (!parsed) {
+        sc2_connection->Capture(sc2::CaptureDirection::Response, 0, 0, data, data_len);
+        sc2_connection->ReleaseResponse(response);
         return 1;
     }
 
-    sc2_connection->PushResponse(response);
+    sc2_connection->Capture(sc2::CaptureDirection::Response, response->response_case(), response->id(), data,
+                            data_len);
 
-    return 1;
+    // Closes the connection if the client stopped consuming responses.
+    return sc2_connection->PushResponse(response, info) ? 1 : 0;
 }
 
 static void ConnectionClosedHandler(const struct mg_connection* conn, void*) {
@@ -86,7 +181,18 @@ static void ConnectionClosedHandler(const struct mg_connection* conn, void*) {
 }
 
 Connection::Connection()
-    : connection_(nullptr), verbose_(false), queue_(), mutex_(), condition_(), has_response_(false) {
+    : connection_(nullptr),
+      verbose_(false),
+      use_response_arenas_(false),
+      arena_pool_(std::make_shared<ResponseArenaPool>()),
+      capturing_(false),
+      queue_(kQueueCapacity),
+      queue_head_(0),
+      queue_tail_(0),
+      waiting_(false),
+      spin_(0),
+      mutex_(),
+      condition_() {
 }
 
 bool Connection::Connect(const std::string& address, int port, bool verbose) {
@@ -125,12 +231,10 @@ void Connection::Send(const SC2APIProtocol::Request* request) {
     if (!connection_) {
         return;
     }
-    size_t size = request->ByteSizeLong();
-    void* buffer = malloc(size);
-    request->SerializeToArray(buffer, (int)size);
-    mg_websocket_write(connection_, MG_WEBSOCKET_OPCODE_BINARY, (const char*)buffer, size);
-
-    free(buffer);
+    const size_t size = SerializeToBuffer(*request, send_buffer_);
+    // Recorded before it is sent, the response may arrive before the write returns.
+    Capture(CaptureDirection::Request, request->request_case(), request->id(), send_buffer_.data(), size);
+    mg_websocket_write(connection_, MG_WEBSOCKET_OPCODE_BINARY, send_buffer_.data(), size);
 
     if (verbose_) {
         std::cout << "Sending: " << request->DebugString();
@@ -138,22 +242,24 @@ void Connection::Send(const SC2APIProtocol::Request* request) {
 }
 
 bool Connection::Receive(SC2APIProtocol::Response*& response, unsigned int timeout_ms) {
-    std::unique_lock<std::mutex> lock(mutex_);
     // Block until a message is recieved.
     if (verbose_) {
         std::cout << "Waiting for response..." << std::endl;
     }
-    auto now = std::chrono::system_clock::now();
-    if (condition_.wait_until(lock, now + std::chrono::milliseconds(timeout_ms), [&] { return queue_.size() != 0; })) {
-        lock.unlock();
+    if (WaitForResponse(std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms))) {
         PopResponse(response);
         return true;
     }
 
-    lock.unlock();
     response = nullptr;
     Disconnect();
-    queue_.clear();
+
+    // Nothing is pushed once disconnected, drop whatever arrived late.
+    while (PollResponse()) {
+        SC2APIProtocol::Response* late_response = nullptr;
+        PopResponse(late_response);
+        ReleaseResponse(late_response);
+    }
 
     // Execute the timeout callback if it exists.
     if (timeout_callback_) {
@@ -163,22 +269,92 @@ bool Connection::Receive(SC2APIProtocol::Response*& response, unsigned int timeo
     return false;
 }
 
-void Connection::PushResponse(SC2APIProtocol::Response*& response) {
-    std::lock_guard<std::mutex> guard(mutex_);
-    queue_.push_back(response);
-    condition_.notify_one();
-    has_response_ = true;
+bool Connection::Receive(GameResponsePtr& response, unsigned int timeout_ms) {
+    SC2APIProtocol::Response* received = nullptr;
+    if (!Receive(received, timeout_ms)) {
+        response = nullptr;
+        return false;
+    }
+
+    google::protobuf::Arena* arena = received ? received->GetArena() : nullptr;
+    if (!arena) {
+        response = GameResponsePtr(received);
+        return true;
+    }
+
+    // The deleter keeps the pool alive, the response may outlive the connection.
+    std::shared_ptr<ResponseArenaPool> arena_pool = arena_pool_;
+    response = GameResponsePtr(received, [arena_pool, arena](const SC2APIProtocol::Response*) {
+        arena_pool->Release(arena);
+    });
+    return true;
+}
+
+bool Connection::PushResponse(SC2APIProtocol::Response*& response) {
+    ResponseInfo info;
+    info.received = std::chrono::steady_clock::now();
+    return PushResponse(response, info);
+}
+
+bool Connection::PushResponse(SC2APIProtocol::Response*& response, const ResponseInfo& info) {
+    const size_t tail = queue_tail_.load(std::memory_order_relaxed);
+    // The game answers requests one at a time, the ring only fills up if the client stops consuming altogether. Waiting
+    // for room would block the civetweb thread for good.
+    if (tail - queue_head_.load(std::memory_order_acquire) >= kQueueCapacity) {
+        std::cerr << "The response queue is full, dropping the response." << std::endl;
+        ReleaseResponse(response);
+        response = nullptr;
+        return false;
+    }
+
+    queue_[tail % kQueueCapacity] = {response, info};
+
+    // Publishing the response and checking for a sleeping consumer are sequentially consistent, so either the consumer
+    // sees the response before going to sleep or the producer sees it sleeping and wakes it up.
+    queue_tail_.store(tail + 1);
+    if (waiting_.load()) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        condition_.notify_one();
+    }
+
+    return true;
 }
 
 void Connection::PopResponse(SC2APIProtocol::Response*& response) {
-    if (queue_.empty())
+    const size_t head = queue_head_.load(std::memory_order_relaxed);
+    if (head == queue_tail_.load(std::memory_order_acquire)) {
         return;
-    std::lock_guard<std::mutex> guard(mutex_);
-    response = queue_.front();
-    queue_.pop_front();
-    if (queue_.empty()) {
-        has_response_ = false;
     }
+
+    const QueuedResponse& queued = queue_[head % kQueueCapacity];
+    response = queued.response;
+    last_response_info_ = queued.info;
+    queue_head_.store(head + 1, std::memory_order_release);
+}
+
+bool Connection::WaitForResponse(std::chrono::steady_clock::time_point deadline) {
+    if (PollResponse()) {
+        return true;
+    }
+
+    const std::chrono::steady_clock::time_point spin_deadline =
+        std::min(deadline, std::chrono::steady_clock::now() + spin_);
+    while (std::chrono::steady_clock::now() < spin_deadline) {
+        if (PollResponse()) {
+            return true;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    waiting_.store(true);
+    const bool received =
+        condition_.wait_until(lock, deadline, [this] { return queue_tail_.load() != queue_head_.load(); });
+    waiting_.store(false);
+    return received;
+}
+
+void Connection::SetSpinWait(unsigned int spin_us) {
+    spin_ = std::chrono::microseconds(spin_us);
 }
 
 void Connection::SetTimeoutCallback(std::function<void()> callback) {
@@ -189,6 +365,51 @@ void Connection::SetConnectionClosedCallback(std::function<void()> callback) {
     connection_closed_callback_ = callback;
 }
 
+bool Connection::StartCapture(const std::string& path) {
+    capturing_ = capture_.Open(path);
+    return capturing_;
+}
+
+void Connection::StopCapture() {
+    capturing_ = false;
+    capture_.Close();
+}
+
+bool Connection::IsCapturing() const {
+    return capturing_;
+}
+
+void Connection::Capture(CaptureDirection direction, int type, uint32_t id, const char* data, size_t size) {
+    if (capturing_) {
+        capture_.Write(direction, type, id, data, size);
+    }
+}
+
+void Connection::SetUseResponseArenas(bool value) {
+    use_response_arenas_ = value;
+}
+
+SC2APIProtocol::Response* Connection::CreateResponse() {
+    if (!use_response_arenas_) {
+        return new SC2APIProtocol::Response();
+    }
+
+    return google::protobuf::Arena::CreateMessage<SC2APIProtocol::Response>(arena_pool_->Acquire());
+}
+
+void Connection::ReleaseResponse(SC2APIProtocol::Response* response) {
+    if (!response) {
+        return;
+    }
+
+    google::protobuf::Arena* arena = response->GetArena();
+    if (arena) {
+        arena_pool_->Release(arena);
+    } else {
+        delete response;
+    }
+}
+
 bool Connection::HasConnection() const {
     return connection_ != nullptr;
 }
@@ -199,7 +420,7 @@ void Connection::Disconnect() {
 }
 
 bool Connection::PollResponse() {
-    return has_response_;
+    return queue_tail_.load(std::memory_order_acquire) != queue_head_.load(std::memory_order_acquire);
 }
 
 }  // namespace sc2
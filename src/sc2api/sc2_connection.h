@@ -5,14 +5,23 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
-#include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
+
+#include "sc2_capture.h"
 
 struct mg_connection;
 
+namespace google::protobuf {
+class Arena;
+class MessageLite;
+}  // namespace google::protobuf
+
 namespace SC2APIProtocol {
 class Request;
 class Response;
@@ -20,6 +29,28 @@ class Response;
 
 namespace sc2 {
 
+class ResponseArenaPool;
+
+typedef std::shared_ptr<SC2APIProtocol::Request> GameRequestPtr;
+typedef std::shared_ptr<const SC2APIProtocol::Response> GameResponsePtr;
+
+//! What is known of a response besides its content.
+struct ResponseInfo {
+    //! Size of the serialized response in bytes.
+    size_t bytes = 0;
+    //! When the response came off the socket.
+    std::chrono::steady_clock::time_point received;
+    //! Time spent parsing the response, in microseconds.
+    uint64_t parse_us = 0;
+};
+
+//! Serializes a message into a buffer, growing the buffer if the message doesn't fit. The size of the message is
+//! computed only once. Reusing the same buffer between calls avoids allocating on every message.
+//!< \param message The message to serialize.
+//!< \param buffer The buffer to serialize into, its size is never reduced.
+//!< \return The size of the serialized message in bytes.
+size_t SerializeToBuffer(const google::protobuf::MessageLite& message, std::vector<char>& buffer);
+
 //! This class acts as a wrapper around a websocket connection and queue responsible for both sending
 //! out and receiving protobuf messages.
 class Connection {
@@ -35,8 +66,7 @@ public:
 
     //! Sends a request via the websocket connection. This function assumes Connect has been called and returned
     //! success. It will assert in debug if that's not the case and will early out in a build that doesn't have asserts
-    //! built in. This function also allocates a byte buffer to accommodate the request, it frees that buffer before
-    //! returning.
+    //! built in. The request is serialized into a buffer owned by the connection that is reused between calls.
     //!< \param request A pointer to the Request object.
     void Send(const SC2APIProtocol::Request* request);
 
@@ -47,17 +77,68 @@ public:
     //! received, false otherwise.
     bool Receive(SC2APIProtocol::Response*& response, unsigned int timeout_ms);
 
+    //! Same as above but the returned pointer owns the response. Responses parsed into an arena hand the arena back
+    //! to the connection when the last reference to them is released.
+    //!< \param response The response pointer to be filled out.
+    //!< \param timeout_ms The max time, in milliseconds, the function will wait to receive a message.
+    //!< \return Returns true if a message is received, false otherwise.
+    bool Receive(GameResponsePtr& response, unsigned int timeout_ms);
+
+    //! Sets how long Receive spins before sleeping until a response arrives. Spinning saves waking up the thread at the
+    //! cost of a busy core meanwhile, it only pays off if the game and the civetweb thread have cores of their own.
+    //! Off by default, on loopback it raised the tail latency rather than lowering it.
+    //!< \param spin_us The time to spin, in microseconds, 0 to sleep right away.
+    void SetSpinWait(unsigned int spin_us);
+
     //! PopResponse is called in the Receive function when a message has been received off of the civetweb thread.
     //! Alternatively you could poll for responses with PollResponse and consume the message manually with this
     //! function. \param response The response pointer to be filled out.
     void PopResponse(SC2APIProtocol::Response*& response);
 
+    //! Size, arrival time and parse time of the last response popped from the queue.
+    const ResponseInfo& GetLastResponseInfo() const {
+        return last_response_info_;
+    }
+
     //! An accessor function that a user can bind a timeout function to.
     //! \param callback A functor or lambda that represents the callback.
     void SetTimeoutCallback(std::function<void()> callback);
 
     void SetConnectionClosedCallback(std::function<void()> callback);
 
+    //! Parses responses into protobuf arenas instead of allocating every submessage on the heap. Arenas are recycled
+    //! once their response has been released, so a steady stream of observations parses without allocating. Responses
+    //! returned through the raw pointer overloads must then be freed with ReleaseResponse instead of delete.
+    //!< \param value True to parse into arenas, false otherwise.
+    void SetUseResponseArenas(bool value);
+
+    //! Creates an empty response, in a recycled arena if response arenas are enabled.
+    //!< \return The new response, free it with ReleaseResponse.
+    SC2APIProtocol::Response* CreateResponse();
+
+    //! Frees a response obtained from CreateResponse, PopResponse or Receive.
+    //!< \param response The response to free, can be null.
+    void ReleaseResponse(SC2APIProtocol::Response* response);
+
+    //! Records every request sent and every response received to a capture file, see CaptureWriter for the format.
+    //!< \param path The path of the capture file, an existing file is replaced.
+    //!< \return Returns true if the capture file could be created.
+    bool StartCapture(const std::string& path);
+
+    //! Stops recording and closes the capture file.
+    void StopCapture();
+
+    //! Whether or not the traffic is being recorded.
+    bool IsCapturing() const;
+
+    //! Appends a message to the capture file if recording, called for responses by the civetweb thread.
+    //!< \param direction Whether the message was sent or received.
+    //!< \param type The request or response case of the message.
+    //!< \param id The id of the request.
+    //!< \param data The serialized message.
+    //!< \param size The size of the serialized message in bytes.
+    void Capture(CaptureDirection direction, int type, uint32_t id, const char* data, size_t size);
+
     //! Whether or not the connection is valid.
     //!< \return true if the connection is valid, false otherwise.
     bool HasConnection() const;
@@ -70,10 +151,17 @@ public:
     bool PollResponse();
 
     //! PushResponse is called by a civetweb thread when it receives a message off the socket. Pushing a response
-    //! triggers a condition and enqueues a message. The condition will cause anyone currently blocking for a response
-    //! (if Receive is called) to wake up and be able to consume that message. \param response A pointer to the Response
-    //! to queue.
-    void PushResponse(SC2APIProtocol::Response*& response);
+    //! enqueues a message and wakes up anyone currently blocking for a response (if Receive is called) so that it can
+    //! consume that message. Responses must be pushed from one thread at a time and popped from one thread at a time.
+    //! \param response A pointer to the Response to queue.
+    //!< \return false if the queue is full, the response is released and set to nullptr then.
+    bool PushResponse(SC2APIProtocol::Response*& response);
+
+    //! Same as above, along with what is known of the response. Responses queued without it are stamped on arrival.
+    //!< \param response A pointer to the Response to queue.
+    //!< \param info Size, arrival time and parse time of the response.
+    //!< \return false if the queue is full, the response is released and set to nullptr then.
+    bool PushResponse(SC2APIProtocol::Response*& response, const ResponseInfo& info);
 
     std::function<void()> timeout_callback_;            //!< Timeout callback.
     std::function<void()> connection_closed_callback_;  //!< Timeout callback.
@@ -81,14 +169,40 @@ public:
     mg_connection* connection_;  //!< A pointer to the civetweb connection object.
 
 private:
+    //! Waits until a response is queued or the deadline passes, spinning first.
+    //!< \return true if a response is queued, false otherwise.
+    bool WaitForResponse(std::chrono::steady_clock::time_point deadline);
+
     bool verbose_;  //!< Will print extra information to console if enabled.
 
-    std::deque<SC2APIProtocol::Response*> queue_;  //!< A queue that contains responses received off the socket.
-    std::mutex mutex_;                             //!< Mutex used in conjunction with the condition.
-    std::condition_variable
-        condition_;  //!< A condition that is signaled when a message has been received off the socket.
+    std::vector<char> send_buffer_;  //!< Serialized requests, grows to the largest request sent so far.
 
-    std::atomic_bool has_response_;  //!< Thread safe bool to check whether the queue is not empty.
+    bool use_response_arenas_;                       //!< Whether responses are parsed into arenas.
+    std::shared_ptr<ResponseArenaPool> arena_pool_;  //!< Arenas of the responses, shared with the response deleters.
+
+    CaptureWriter capture_;       //!< Recorder of the traffic.
+    std::atomic_bool capturing_;  //!< Whether the traffic is recorded, avoids locking the recorder otherwise.
+
+    struct QueuedResponse {
+        SC2APIProtocol::Response* response;
+        ResponseInfo info;
+    };
+
+    //! Capacity of the queue, far beyond the number of requests a client ever has in flight.
+    static const size_t kQueueCapacity = 1024;
+
+    //! Ring of the responses received off the socket, written by the civetweb thread and read by the client thread
+    //! without locking. Indices grow forever and wrap around the ring.
+    std::vector<QueuedResponse> queue_;
+    alignas(64) std::atomic<size_t> queue_head_;  //!< Index of the next response to pop, written by the consumer.
+    alignas(64) std::atomic<size_t> queue_tail_;  //!< Index of the next response to push, written by the producer.
+    alignas(64) std::atomic_bool waiting_;        //!< Whether the consumer sleeps on the condition.
+    ResponseInfo last_response_info_;             //!< Information on the last response popped from the queue.
+
+    std::chrono::microseconds spin_;  //!< How long to spin before sleeping on the condition.
+    std::mutex mutex_;                //!< Mutex used in conjunction with the condition.
+    std::condition_variable
+        condition_;  //!< A condition that is signaled when a message is received while the consumer sleeps.
 };
 
 }  // namespace sc2
@@ -7,6 +7,7 @@
 #include "sc2_data.h"
 #include "sc2_game_settings.h"
 #include "sc2_proto_interface.h"
+#include "sc2_unit.h"
 
 namespace sc2 {
 
@@ -31,6 +32,8 @@ public:
 
     virtual bool Step(int count = 1) = 0;
     virtual bool WaitStep() = 0;
+    // Sends the step and the observation request back to back and updates the observation, a single round trip.
+    virtual bool StepAndObserve(int count = 1) = 0;
 
     virtual bool SaveReplay(const std::string& path) = 0;
 
@@ -70,6 +73,18 @@ public:
 
     virtual void UseGeneralizedAbility(bool value) = 0;
 
+    // Unit memory.
+    //! Sets how long dead units are kept after they were last seen. Until then pointers to them, e.g. the one passed
+    //! to OnUnitDestroyed, stay valid; afterwards their memory is reused for new units.
+    //!< \param game_loops Game loops to keep dead units for, UnitPool::kKeepDeadUnits, the default, keeps them for
+    //!< the whole game.
+    virtual void SetDeadUnitRetention(uint32_t game_loops) = 0;
+    //! Forgets the units of the previous game, done when joining a game or starting a replay. Pointers to those units
+    //! are invalid afterwards.
+    virtual void ResetUnits() = 0;
+    //! The memory held by the units, e.g. to watch it while processing many replays.
+    virtual UnitPoolReport GetUnitPoolReport() const = 0;
+
     // Save/Load.
     virtual void Save() = 0;
     virtual void Load() = 0;
@@ -4,7 +4,6 @@
 #include <cassert>
 #include <fstream>
 #include <iostream>
-#include <thread>
 
 #include "s2clientprotocol/sc2api.pb.h"
 #include "sc2_agent.h"
@@ -15,22 +14,11 @@
 #include "sc2_replay_observer.h"
 #include "sc2utils/sc2_manage_process.h"
 #include "sc2utils/sc2_scan_directory.h"
+#include "sc2utils/sc2_thread_pool.h"
+#include "sc2utils/sc2_trace.h"
 
 namespace sc2 {
 
-void RunParallel(const std::function<void(Agent* a)>& step, std::vector<Agent*>& agents) {
-    // Run all steps in parallel.
-    std::vector<std::thread> threads(agents.size());
-    for (size_t i = 0; i < agents.size(); ++i) {
-        Agent* a = agents[i];
-        threads[i] = std::thread(std::bind(step, a));
-    }
-
-    for (auto& t : threads) {
-        t.join();
-    }
-}
-
 int LaunchProcess(ProcessSettings& process_settings, Client* client, int window_width, int window_height,
                   int window_start_x, int window_start_y, int port, int client_num = 0) {
     assert(client);
@@ -87,6 +75,24 @@ int LaunchProcess(ProcessSettings& process_settings, Client* client, int window_
     return pi.port;
 }
 
+void ConfigureProto(ProtoInterface& proto, const ProcessSettings& process_settings, int port) {
+    proto.SetUseResponseArenas(process_settings.response_arenas);
+    proto.SetPipelining(process_settings.pipelining);
+
+    // Keep recording to the same file when reconnecting, e.g. between replays.
+    if (!process_settings.capture_directory.empty() && !proto.IsCapturing()) {
+        const std::string path = process_settings.capture_directory + "/sc2_" + std::to_string(port) + ".sc2capture";
+        if (!proto.StartCapture(path)) {
+            std::cerr << "Failed to create the capture file " << path << std::endl;
+        }
+    }
+
+    if (!process_settings.stats_directory.empty()) {
+        const std::string path = process_settings.stats_directory + "/sc2_" + std::to_string(port) + "_stats.json";
+        proto.SetStatsDump(path, process_settings.stats_interval_ms);
+    }
+}
+
 bool AttachClients(ProcessSettings& process_settings, std::vector<Client*> clients) {
     bool connected = false;
 
@@ -95,6 +101,7 @@ bool AttachClients(ProcessSettings& process_settings, std::vector<Client*> clien
         const ProcessInfo& pi = process_settings.process_info[i];
         Client* c = clients[i];
 
+        ConfigureProto(c->Control()->Proto(), process_settings, pi.port);
         connected = c->Control()->Connect(process_settings.net_address, pi.port, process_settings.timeout_ms);
         if (!connected)
             throw ClientConnectionError(process_settings.net_address, pi.port);
@@ -175,6 +182,15 @@ public:
 
     bool Relaunch(ReplayObserver* replay_observer);
 
+    // Run all steps in parallel on the thread pool.
+    template <typename Step, typename ClientType>
+    void RunParallel(const Step& step, const std::vector<ClientType*>& clients) {
+        thread_pool_.ParallelFor(clients.size(), [&step, &clients](size_t i) { step(clients[i]); });
+    }
+
+    // Workers running the steps of agents and replay observers in parallel, kept alive between steps.
+    ThreadPool thread_pool_;
+
     int window_width_ = 1024;
     int window_height_ = 768;
 
@@ -186,6 +202,9 @@ public:
     int last_port_ = 0;
 
     bool use_generalized_ability_id = true;
+
+    // Chrome trace written when the coordinator is destroyed, empty if not tracing.
+    std::string trace_path_;
 };
 
 CoordinatorImp::CoordinatorImp()
@@ -201,6 +220,10 @@ CoordinatorImp::~CoordinatorImp() {
     for (auto& p : process_settings_.process_info) {
         TerminateProcess(p.process_id);
     }
+
+    if (!trace_path_.empty() && !WriteTrace(trace_path_)) {
+        std::cerr << "Failed to write the trace " << trace_path_ << std::endl;
+    }
 }
 
 bool CoordinatorImp::AnyObserverAvailable() const {
@@ -287,8 +310,10 @@ void CoordinatorImp::StartReplay() {
 }
 
 void CoordinatorImp::StepAgents() {
+    SC2_TRACE_SCOPE("StepAgents");
     auto step_agent = [this](Agent* a) {
         ControlInterface* control = a->Control();
+        SC2_TRACE_SCOPE_ID("StepAgent", control->Proto().GetAssignedPort());
 
         if (control->GetAppState() != AppState::normal) {
             return;
@@ -302,8 +327,12 @@ void CoordinatorImp::StepAgents() {
             return;
         }
 
-        control->Step(process_settings_.step_size);
-        control->WaitStep();
+        if (process_settings_.step_and_observe) {
+            control->StepAndObserve(process_settings_.step_size);
+        } else {
+            control->Step(process_settings_.step_size);
+            control->WaitStep();
+        }
         if (process_settings_.multi_threaded) {
             CallOnStep(a);
         }
@@ -326,17 +355,20 @@ void CoordinatorImp::StepAgents() {
                 continue;
             }
 
+            SC2_TRACE_SCOPE_ID("CallOnStep", a->Control()->Proto().GetAssignedPort());
             CallOnStep(a);
         }
     }
 }
 
 void CoordinatorImp::StepAgentsRealtime() {
+    SC2_TRACE_SCOPE("StepAgentsRealtime");
     auto step_agent = [](Agent* a) {
         ControlInterface* control = a->Control();
         if (!control) {
             return;
         }
+        SC2_TRACE_SCOPE_ID("StepAgent", control->Proto().GetAssignedPort());
 
         if (control->GetAppState() != AppState::normal) {
             return;
@@ -377,8 +409,10 @@ void CoordinatorImp::StepAgentsRealtime() {
 }
 
 void CoordinatorImp::StepReplayObservers() {
+    SC2_TRACE_SCOPE("StepReplayObservers");
     // Run all replay observers.
     auto run_replay = [this](ReplayObserver* r) {
+        SC2_TRACE_SCOPE_ID("StepReplayObserver", r->Control()->Proto().GetAssignedPort());
         if (r->Control()->GetAppState() != AppState::normal) {
             return;
         }
@@ -393,8 +427,12 @@ void CoordinatorImp::StepReplayObservers() {
         }
 
         if (r->Control()->IsInGame()) {
-            r->Control()->Step(process_settings_.step_size);
-            r->Control()->WaitStep();
+            if (process_settings_.step_and_observe) {
+                r->Control()->StepAndObserve(process_settings_.step_size);
+            } else {
+                r->Control()->Step(process_settings_.step_size);
+                r->Control()->WaitStep();
+            }
 
             // If multithreaded run everyones OnStep in parallel.
             if (process_settings_.multi_threaded) {
@@ -411,17 +449,7 @@ void CoordinatorImp::StepReplayObservers() {
     if (replay_observers_.size() == 1) {
         run_replay(replay_observers_.front());
     } else {
-        // Run all steps in parallel.
-        std::vector<std::thread> threads;
-        threads.reserve(replay_observers_.size());
-        for (auto r : replay_observers_) {
-            threads.emplace_back(run_replay, r);
-        }
-
-        // Join all threads.
-        for (auto& t : threads) {
-            t.join();
-        }
+        RunParallel(run_replay, replay_observers_);
     }
 
     // Do everyones OnStep, if not multi threaded, in single threaded mode.
@@ -438,8 +466,10 @@ void CoordinatorImp::StepReplayObservers() {
 }
 
 void CoordinatorImp::StepReplayObserversRealtime() {
+    SC2_TRACE_SCOPE("StepReplayObserversRealtime");
     // Run all replay observers.
     auto run_replay = [this](ReplayObserver* r) {
+        SC2_TRACE_SCOPE_ID("StepReplayObserver", r->Control()->Proto().GetAssignedPort());
         if (r->Control()->GetAppState() != AppState::normal) {
             return;
         }
@@ -470,17 +500,7 @@ void CoordinatorImp::StepReplayObserversRealtime() {
     if (replay_observers_.size() == 1) {
         run_replay(replay_observers_.front());
     } else {
-        // Run all steps in parallel.
-        std::vector<std::thread> threads;
-        threads.reserve(replay_observers_.size());
-        for (auto r : replay_observers_) {
-            threads.emplace_back(run_replay, r);
-        }
-
-        // Join all threads.
-        for (auto& t : threads) {
-            t.join();
-        }
+        RunParallel(run_replay, replay_observers_);
     }
 
     // Do everyones OnStep, if not multi threaded, in single threaded mode.
@@ -638,6 +658,7 @@ bool CoordinatorImp::Relaunch(ReplayObserver* replay_observer) {
 
     const ProcessInfo& pi_new = control->GetProcessInfo();
 
+    ConfigureProto(control->Proto(), process_settings_, pi_new.port);
     return control->Connect(process_settings_.net_address, pi_new.port, process_settings_.timeout_ms);
 }
 
@@ -730,6 +751,7 @@ void Coordinator::LaunchStarcraft() {
 }
 
 void Coordinator::Connect(int port) {
+    ConfigureProto(imp_->agents_.front()->Control()->Proto(), imp_->process_settings_, port);
     if (!imp_->agents_.front()->Control()->Connect(imp_->process_settings_.net_address, port,
                                                    imp_->process_settings_.timeout_ms)) {
         std::cerr << "Failed to attach to starcraft." << std::endl;
@@ -751,6 +773,7 @@ void Coordinator::WaitForAllResponses() {
 }
 
 bool Coordinator::Update() {
+    SC2_TRACE_SCOPE("Coordinator::Update");
     if (imp_->agents_.size() > 0) {
         if (imp_->process_settings_.realtime) {
             imp_->StepAgentsRealtime();
@@ -871,6 +894,52 @@ void Coordinator::SetTimeoutMS(uint32_t timeout_ms) {
     imp_->process_settings_.timeout_ms = timeout_ms;
 }
 
+void Coordinator::SetResponseArenas(bool value) {
+    assert(!imp_->starcraft_started_);
+    imp_->process_settings_.response_arenas = value;
+}
+
+void Coordinator::SetPipelining(bool value) {
+    assert(!imp_->starcraft_started_);
+    imp_->process_settings_.pipelining = value;
+}
+
+void Coordinator::SetCaptureDirectory(const std::string& path) {
+    assert(!imp_->starcraft_started_);
+    imp_->process_settings_.capture_directory = path;
+}
+
+void Coordinator::SetStatsDirectory(const std::string& path, unsigned int interval_ms) {
+    assert(!imp_->starcraft_started_);
+    imp_->process_settings_.stats_directory = path;
+    imp_->process_settings_.stats_interval_ms = interval_ms;
+}
+
+void Coordinator::SetStepAndObserve(bool value) {
+    assert(!imp_->starcraft_started_);
+    imp_->process_settings_.step_and_observe = value;
+}
+
+void Coordinator::SetThreadPoolSize(size_t thread_count) {
+    imp_->thread_pool_.Reserve(thread_count);
+}
+
+void Coordinator::SetTraceFile(const std::string& path) {
+#if !defined(SC2_TRACING)
+    if (!path.empty()) {
+        std::cerr << "Tracing is compiled out, configure the project with -DSC2_TRACING=ON to record " << path
+                  << std::endl;
+    }
+#endif
+    imp_->trace_path_ = path;
+    if (path.empty()) {
+        StopTracing();
+    } else {
+        SetTraceThreadName("Coordinator");
+        StartTracing();
+    }
+}
+
 void Coordinator::SetPortStart(int port_start) {
     assert(!imp_->starcraft_started_);
     imp_->process_settings_.port_start = port_start;
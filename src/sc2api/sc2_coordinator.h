@@ -42,6 +42,17 @@ public:
     //! are thread-safe if they reach into shared code. \param value True to multithread, false otherwise.
     void SetMultithreaded(bool value);
 
+    //! Sets the number of worker threads kept alive to step agents and replay observers in parallel. The pool grows on
+    //! its own when more clients step at once, setting the size up front avoids starting threads during the first steps.
+    //! \param thread_count Number of worker threads.
+    void SetThreadPoolSize(size_t thread_count);
+
+    //! Records a timeline of the phases of every Update, e.g. stepping, waiting for the game, parsing the observation
+    //! and running OnStep, on every thread. The timeline is written as a Chrome trace when the coordinator is
+    //! destroyed, open it in Perfetto or chrome://tracing. Requires configuring the project with -DSC2_TRACING=ON.
+    //! \param path The trace file to write, an empty path stops recording.
+    void SetTraceFile(const std::string& path);
+
     //! Specifies whether the game should run in realtime or not. If the game is running in real time that means the
     //! coordinator is not stepping it forward. The game is running and your bot reaches into it asynchronously to read
     //! state. \param value True to be realtime, false otherwise.
@@ -66,6 +77,32 @@ public:
     //! \param value timeout_ms in milliseconds.
     void SetTimeoutMS(uint32_t timeout_ms = kDefaultProtoInterfaceTimeout);
 
+    //! Parses the responses of the game into protobuf arenas that are recycled between steps instead of allocating every
+    //! submessage on the heap. Reduces the allocations of large observations considerably.
+    //! \param value True to parse into arenas, false otherwise.
+    void SetResponseArenas(bool value);
+
+    //! Sends actions and debug commands without waiting for their acknowledgments, which are consumed along with the
+    //! response of the following step or observation. Saves a round trip per request, most noticeable in realtime.
+    //! \param value True to pipeline requests, false otherwise.
+    void SetPipelining(bool value);
+
+    //! Records the requests and responses of every client to a capture file in the given directory, named after the
+    //! port of the client. Captures can be read back with CaptureReader to reproduce a game offline.
+    //! \param path Directory of the capture files, an empty path disables recording.
+    void SetCaptureDirectory(const std::string& path);
+
+    //! Periodically writes the request counts, sizes and latencies of every client as JSON to a file in the given
+    //! directory, named after the port of the client. The statistics can also be queried from ProtoInterface::GetStats.
+    //! \param path Directory of the statistics files, an empty path disables writing them.
+    //! \param interval_ms Minimum time between two writes of a file.
+    void SetStatsDirectory(const std::string& path, unsigned int interval_ms = 10000);
+
+    //! Specifies whether each step requests the observation right behind the step instead of waiting for the step to
+    //! complete first. Saves a round trip per step and is enabled by default.
+    //! \param value True to request both at once, false otherwise.
+    void SetStepAndObserve(bool value);
+
     //! Sets the first port number to use. Subsequent port assignments are sequential.
     //! \param port_start First port number.
     void SetPortStart(int port_start);
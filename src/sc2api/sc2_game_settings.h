@@ -34,6 +34,18 @@ struct ProcessSettings {
     // Run all OnSteps in parallel.
     bool multi_threaded;
     bool full_screen;
+    // Parse responses into recycled protobuf arenas.
+    bool response_arenas = false;
+    // Send requests without waiting for the responses of acknowledgment only requests.
+    bool pipelining = false;
+    // Request the observation together with each step.
+    bool step_and_observe = true;
+    // Directory to record the protocol traffic of each client to, nothing is recorded if empty.
+    std::string capture_directory;
+    // Directory to write the protocol statistics of each client to as JSON, nothing is written if empty.
+    std::string stats_directory;
+    // Minimum time between two writes of the protocol statistics.
+    unsigned int stats_interval_ms = 10000;
     std::vector<std::string> extra_command_lines;
     // PID and port of all running sc2 processes.
     std::vector<ProcessInfo> process_info;
@@ -36,6 +36,8 @@ enum AIBuild { RandomBuild = 1, Rush = 2, Timing = 3, Power = 4, Macro = 5, Air
 
 enum class ChatChannel { All = 0, Team = 1 };
 
+enum class Visibility { Hidden = 0, Fogged = 1, Visible = 2, FullHidden = 3 };
+
 class Agent;
 
 //! Setup for a player in a game.
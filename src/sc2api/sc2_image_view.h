@@ -0,0 +1,71 @@
+/*! \file sc2_image_view.h
+    \brief A view of the pixels of an image, without the protocol.
+*/
+#pragma once
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+
+namespace SC2APIProtocol {
+class ImageData;
+}  // namespace SC2APIProtocol
+
+namespace sc2 {
+
+struct ImageData;
+
+//! Pixels of a feature layer or rendered image, referencing the bytes of the response they were received in instead
+//! of copying them. A view obtained from a response keeps the response alive for as long as it is held. Only the
+//! constructors need the protocol, code that draws or reads views can include this header alone.
+struct ImageView {
+    //! First byte of the top row.
+    const char* data;
+    int width;
+    int height;
+    int bits_per_pixel;
+    //! Bytes from the start of a row to the start of the next one. Images of less than 8 bits per pixel pack their
+    //! rows back to back and have a stride of 0.
+    int stride;
+    //! Keeps the bytes alive, empty if the view references an image owned by someone else.
+    std::shared_ptr<const void> owner;
+
+    ImageView() : data(nullptr), width(0), height(0), bits_per_pixel(0), stride(0) {
+    }
+
+    //! A view of an image that must outlive the view. The view is empty if the bytes don't cover the image.
+    explicit ImageView(const ImageData& image);
+
+    //! A view of an image of a response that must outlive the view, see ObservationInterface::GetImageView for a view
+    //! that keeps the response alive. The view is empty if the bytes don't cover the image.
+    explicit ImageView(const SC2APIProtocol::ImageData& image);
+
+    //! Whether the view references a non-empty image.
+    bool IsValid() const {
+        return data != nullptr && width > 0 && height > 0 && bits_per_pixel > 0;
+    }
+
+    //! Number of bytes covered by the image.
+    size_t Size() const {
+        if (!IsValid()) {
+            return 0;
+        }
+
+        if (stride > 0) {
+            return static_cast<size_t>(stride) * height;
+        }
+
+        return (static_cast<size_t>(width) * height * bits_per_pixel + 7) / 8;
+    }
+
+    //! First byte of a row, for images of at least 8 bits per pixel.
+    const char* Row(int y) const {
+        return data + static_cast<ptrdiff_t>(y) * stride;
+    }
+
+private:
+    ImageView(const std::string& bytes, int image_width, int image_height, int image_bits_per_pixel);
+};
+
+}  // namespace sc2
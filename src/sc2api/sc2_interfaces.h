@@ -17,6 +17,7 @@ be of little concern to the consumer.
 
 // Forward declarations to avoid including proto headers everywhere.
 namespace SC2APIProtocol {
+class ImageData;
 class Observation;
 }
 
@@ -28,8 +29,11 @@ enum class ABILITY_ID;
 class ObservationInterface;
 struct Score;
 struct GameInfo;
-
-enum class Visibility { Hidden = 0, Fogged = 1, Visible = 2, FullHidden = 3 };
+struct MapState;
+struct StaticMapGrids;
+struct ImageView;
+struct RenderedFrameView;
+struct UnitColumns;
 
 //! Used to filter out units when querying. You can use this filter to get all full health units, for example.
 //!< \param unit The unit in question to filter.
@@ -38,6 +42,11 @@ enum class Visibility { Hidden = 0, Fogged = 1, Visible = 2, FullHidden = 3 };
 //!< the list. \sa GetUnits()
 typedef std::function<bool(const Unit& unit)> Filter;
 
+//! Used to select unit types when querying units by type, e.g. IsTownHall() or IsGeyser().
+//!< \param type The unit type in question.
+//!< \return Whether the units of the type are added to the list. \sa GetUnitsOfType()
+typedef std::function<bool(UNIT_TYPEID type)> TypeFilter;
+
 //! The ObservationInterface reflects the current state of the game. Guaranteed to be valid when OnGameStart or OnStep
 //! is called.
 class ObservationInterface {
@@ -56,13 +65,19 @@ public:
     //!< \return List of all ally and visible enemy and neutral units.
     virtual Units GetUnits() const = 0;
 
+    //! Get all units belonging to a certain alliance. The list is built once per observation, so this call doesn't
+    //! allocate. The reference stays valid until the next observation is received.
+    //!< \param alliance The faction the units belong to.
+    //!< \return A list of units that belong to the alliance.
+    virtual const Units& GetUnits(Unit::Alliance alliance) const = 0;
+
     //! Get all units belonging to a certain alliance and meet the conditions provided by the filter. The unit structure
     //! is const data only. Therefore editing that data will not change any in game state. See the ActionInterface for
     //! changing Unit state.
     //!< \param alliance The faction the units belong to.
     //!< \param filter A functor or lambda used to filter out any unneeded units in the list.
     //!< \return A list of units that meet the conditions provided by alliance and filter.
-    virtual Units GetUnits(Unit::Alliance alliance, Filter filter = {}) const = 0;
+    virtual Units GetUnits(Unit::Alliance alliance, Filter filter) const = 0;
 
     //! Get all units belonging to self that meet the conditions provided by the filter. The unit structure is const
     //! data only. Therefore editing that data will not change any in game state. See the ActionInterface for changing
@@ -71,11 +86,61 @@ public:
     //!< \return A list of units that meet the conditions provided by the filter.
     virtual Units GetUnits(Filter filter) const = 0;
 
+    //! Same as GetUnits(Filter) but appends the units to a caller provided list, so its capacity can be reused
+    //! between calls. The list is not cleared.
+    //!< \param units The list to append the units to.
+    //!< \param filter A functor or lambda used to filter out any unneeded units in the list.
+    virtual void GetUnits(Units& units, Filter filter = {}) const = 0;
+
+    //! Same as GetUnits(Unit::Alliance, Filter) but appends the units to a caller provided list, so its capacity can
+    //! be reused between calls. The list is not cleared.
+    //!< \param units The list to append the units to.
+    //!< \param alliance The faction the units belong to.
+    //!< \param filter A functor or lambda used to filter out any unneeded units in the list.
+    virtual void GetUnits(Units& units, Unit::Alliance alliance, Filter filter = {}) const = 0;
+
+    //! Get the units of an alliance and type, same as GetUnits(alliance, IsUnit(type)). The units are grouped by type
+    //! once per observation, so this call only visits the matching units and doesn't allocate.
+    //!< \param alliance The faction the units belong to.
+    //!< \param type The type of the units.
+    //!< \return The units in the order they were observed, valid until the next observation is received.
+    virtual const Units& GetUnitsOfType(Unit::Alliance alliance, UnitTypeID type) const = 0;
+
+    //! Get the units of an alliance and any of the given types, only the units of these types are visited.
+    //!< \param alliance The faction the units belong to.
+    //!< \param types The types of the units, each listed once.
+    //!< \return The units grouped by type, in the order of the types.
+    virtual Units GetUnitsOfType(Unit::Alliance alliance, const std::vector<UnitTypeID>& types) const = 0;
+
+    //! Get the units of an alliance whose type passes the filter, e.g. IsTownHall() or IsGeyser(). The filter is
+    //! called once per type present in the observation instead of once per unit.
+    //!< \param alliance The faction the units belong to.
+    //!< \param filter A functor or lambda selecting the unit types.
+    //!< \return The units grouped by type.
+    virtual Units GetUnitsOfType(Unit::Alliance alliance, TypeFilter filter) const = 0;
+
     //! Get the unit state as represented by the last call to GetObservation.
     //!< \param tag Unique tag of the unit.
     //!< \return Pointer to the Unit object.
     virtual const Unit* GetUnit(Tag tag) const = 0;
 
+    //! Get the units of which a tracked field changed since the previous observation, e.g. to only update the units
+    //! that moved or got new orders instead of scanning all units. See Unit::changed_fields for which fields changed.
+    //! Units seen for the first time are included with all fields changed.
+    //!< \return List of the changed units, valid until the next observation is received.
+    virtual const Units& GetChangedUnits() const = 0;
+
+    //! Get the units of the current observation stored field by field, for queries that scan a field of many units
+    //! such as range checks and nearest target searches. The columns are built on the first call after an
+    //! observation, bots that don't use them pay nothing.
+    //!< \return The columns, valid until the next observation is received.
+    virtual const UnitColumns& GetUnitColumns() const = 0;
+
+    //! Get the size of arrays indexed by Unit::index, e.g. to keep data of units in a vector instead of a map keyed
+    //! by tag. Grows as units are seen and starts over when a new game starts.
+    //!< \return One past the highest unit index of the game.
+    virtual uint32_t GetMaxUnitIndex() const = 0;
+
     //! Gets a list of actions performed as abilities applied to units. For use with the raw option.
     //!< \return List of raw actions.
     virtual const RawActions& GetRawActions() const = 0;
@@ -198,11 +263,27 @@ public:
     //!< \return Creep.
     virtual bool HasCreep(const Point2D& point) const = 0;
 
+    //! Batched version of HasCreep.
+    //!< \param points Positions to sample.
+    //!< \return Creep of each point, in the same order as the points.
+    virtual std::vector<bool> HasCreep(const std::vector<Point2D>& points) const = 0;
+
     //! Returns visibility value of the given point for the current player.
     //!< \param point Position to sample.
     //!< \return Visibility.
     virtual Visibility GetVisibility(const Point2D& point) const = 0;
 
+    //! Batched version of GetVisibility.
+    //!< \param points Positions to sample.
+    //!< \return Visibility of each point, in the same order as the points.
+    virtual std::vector<Visibility> GetVisibility(const std::vector<Point2D>& points) const = 0;
+
+    //! Gets creep and visibility of the current game loop decoded into dense grids. Useful to sweep whole regions
+    //! without sampling point by point. The grids are refreshed on each observation.
+    //!< \return The decoded map state.
+    //!< \sa MapState
+    virtual const MapState& GetMapState() const = 0;
+
     //! Returns 'true' if the given point on the terrain is pathable. This does not
     // include pathing blockers like structures. For more accurate pathing results
     // use QueryInterface::PathingDistance.
@@ -222,6 +303,12 @@ public:
     //!< \return Height.
     virtual float TerrainHeight(const Point2D& point) const = 0;
 
+    //! Gets pathing, placement and terrain height of the current map decoded into dense grids. The grids are built
+    //! once per game together with the GameInfo and are meant for bulk terrain analysis.
+    //!< \return The decoded static grids.
+    //!< \sa StaticMapGrids
+    virtual const StaticMapGrids& GetStaticMapGrids() const = 0;
+
     //! A pointer to the low-level protocol data for the current observation. While it's possible to extract most
     //! in-game data from this pointer
     // it is highly discouraged. It should only be used for extracting feature layers because it would be inefficient to
@@ -229,6 +316,18 @@ public:
     //!< \return A const pointer to the Observation.
     //!< \sa Observation GetObservation()
     virtual const SC2APIProtocol::Observation* GetRawObservation() const = 0;
+
+    //! Views the pixels of a feature layer or rendered image of the current observation without copying them. The view
+    //! keeps the observation alive, so it stays valid after the following steps.
+    //!< \param image An image of the observation returned by GetRawObservation.
+    //!< \return The view, invalid if the image is empty or its size doesn't match its dimensions.
+    //!< \sa ImageView GetRawObservation()
+    virtual ImageView GetImageView(const SC2APIProtocol::ImageData& image) const = 0;
+
+    //! Views the rendered map and minimap of the current observation without copying them.
+    //!< \return The views, invalid if the game isn't rendered.
+    //!< \sa RenderedFrameView
+    virtual RenderedFrameView GetRenderedFrame() const = 0;
 };
 
 //! The QueryInterface provides additional data not contained in the observation.
@@ -7,42 +7,86 @@ namespace sc2 {
 ImageData::ImageData() : width(0), height(0), bits_per_pixel(0) {
 }
 
+ImageView::ImageView(const ImageData& image)
+    : ImageView(image.data, image.width, image.height, image.bits_per_pixel) {
+}
+
+ImageView::ImageView(const SC2APIProtocol::ImageData& image)
+    : ImageView(image.data(), image.size().x(), image.size().y(), image.bits_per_pixel()) {
+}
+
+ImageView::ImageView(const std::string& bytes, int image_width, int image_height, int image_bits_per_pixel)
+    : data(bytes.data()),
+      width(image_width),
+      height(image_height),
+      bits_per_pixel(image_bits_per_pixel),
+      stride(image_bits_per_pixel >= 8 ? image_width * image_bits_per_pixel / 8 : 0) {
+    // Rows are read without bounds checks, an image whose bytes don't match its size isn't viewed at all.
+    if (Size() == 0 || bytes.size() != Size()) {
+        *this = ImageView();
+    }
+}
+
 GameInfo::GameInfo() : width(0), height(0) {
 }
 
-SampleImage::SampleImage(const SC2APIProtocol::ImageData& data)
-    : data_(data.data()), area_({0, 0}, {data.size().x(), data.size().y()}), bits_per_pixel_(data.bits_per_pixel()) {
+MapState::MapState() : width(0), height(0) {
 }
 
-SampleImage::SampleImage(const ImageData& data)
-    : data_(data.data), area_({0, 0}, {data.width, data.height}), bits_per_pixel_(data.bits_per_pixel) {
+bool MapState::HasCreep(const Point2DI& point) const {
+    if (!Contain(point))
+        return false;
+
+    return creep[point.x + point.y * width] != 0;
+}
+
+Visibility MapState::GetVisibility(const Point2DI& point) const {
+    if (!Contain(point))
+        return Visibility::FullHidden;
+
+    return static_cast<Visibility>(visibility[point.x + point.y * width]);
+}
+
+bool MapState::Contain(const Point2DI& point) const {
+    return point.x >= 0 && point.x < width && point.y >= 0 && point.y < height;
+}
+
+SampleImage::SampleImage(const SC2APIProtocol::ImageData& data) : SampleImage(ImageView(data)) {
+}
+
+SampleImage::SampleImage(const ImageData& data) : SampleImage(ImageView(data)) {
+}
+
+SampleImage::SampleImage(const ImageView& view) : image_(view), area_({0, 0}, {view.width, view.height}) {
 }
 
 bool SampleImage::GetBit(const Point2DI& point, bool* dst) const {
-    assert(bits_per_pixel_ == 1);
+    assert(image_.IsValid());
+    assert(image_.bits_per_pixel == 1);
 
     if (!area_.Contain(point))
         return false;
 
     div_t idx = div(point.x + point.y * area_.Width(), 8);
-    *dst = (data_[idx.quot] >> (7 - idx.rem)) & 1;
+    *dst = (image_.data[idx.quot] >> (7 - idx.rem)) & 1;
     return true;
 }
 
 bool SampleImage::GetBit(const Point2DI& point, unsigned char* dst) const {
-    assert(bits_per_pixel_ > 1);
+    // Views of images whose bytes don't cover them are empty.
+    assert(image_.IsValid());
+    assert(image_.bits_per_pixel > 1);
 
     if (!area_.Contain(point))
         return false;
 
     // Image data is stored with an upper left origin.
-    assert(data_.size() == area_.Width() * area_.Height());
-    *dst = data_[point.x + point.y * area_.Width()];
+    *dst = static_cast<unsigned char>(image_.Row(point.y)[point.x]);
     return true;
 }
 
 int SampleImage::BPP() const {
-    return bits_per_pixel_;
+    return image_.bits_per_pixel;
 }
 
 Rect2DI SampleImage::Area() const {
@@ -133,4 +177,59 @@ void HeightMap::Dump(const std::string& file_path) const {
     }
 }
 
+StaticMapGrids::StaticMapGrids() : width(0), height(0) {
+}
+
+StaticMapGrids::StaticMapGrids(const GameInfo& info) : width(info.width), height(info.height) {
+    if (width <= 0 || height <= 0) {
+        width = 0;
+        height = 0;
+        return;
+    }
+
+    const size_t size = static_cast<size_t>(width) * height;
+    pathing.resize(size);
+    placement.resize(size);
+    terrain_height.resize(size);
+
+    // The layers are decoded through the samplers only once, so the packed images are never touched afterwards.
+    PathingGrid pathing_grid(info);
+    PlacementGrid placement_grid(info);
+    HeightMap height_map(info);
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const size_t idx = x + static_cast<size_t>(y) * width;
+            pathing[idx] = pathing_grid.IsPathable({x, y}) ? 1 : 0;
+            placement[idx] = placement_grid.IsPlacable({x, y}) ? 1 : 0;
+            terrain_height[idx] = height_map.TerrainHeight({x, y});
+        }
+    }
+}
+
+bool StaticMapGrids::IsPathable(const Point2DI& point) const {
+    if (!Contain(point))
+        return false;
+
+    return pathing[point.x + point.y * width] != 0;
+}
+
+bool StaticMapGrids::IsPlacable(const Point2DI& point) const {
+    if (!Contain(point))
+        return false;
+
+    return placement[point.x + point.y * width] != 0;
+}
+
+float StaticMapGrids::TerrainHeight(const Point2DI& point) const {
+    if (!Contain(point))
+        return 0.0f;
+
+    return terrain_height[point.x + point.y * width];
+}
+
+bool StaticMapGrids::Contain(const Point2DI& point) const {
+    return point.x >= 0 && point.x < width && point.y >= 0 && point.y < height;
+}
+
 }  // namespace sc2
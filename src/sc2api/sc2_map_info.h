@@ -9,6 +9,7 @@
 #include "s2clientprotocol/sc2api.pb.h"
 #include "sc2_common.h"
 #include "sc2_gametypes.h"
+#include "sc2_image_view.h"
 
 namespace sc2 {
 
@@ -28,6 +29,12 @@ struct RenderedFrame {
     ImageData minimap;
 };
 
+//! Rendered data for a game frame, referencing the observation it was received in.
+struct RenderedFrameView {
+    ImageView map;
+    ImageView minimap;
+};
+
 //! Setup structure for feature layers or rendered images.
 struct SpatialSetup {
     //! For feature layers only, determines the world space size of the camera.
@@ -105,11 +112,32 @@ struct GameInfo {
     GameInfo();
 };
 
+//! Creep and visibility of the current game loop, decoded into dense grids with one byte per cell.
+//! Cells are stored row-major, the value of a cell (x, y) is located at index x + y * width.
+struct MapState {
+    int width;
+    int height;
+    //! 1 if a cell is covered with creep, 0 otherwise.
+    std::vector<uint8_t> creep;
+    //! Visibility of a cell for the current player, holds values of the Visibility enum.
+    std::vector<uint8_t> visibility;
+
+    MapState();
+
+    bool HasCreep(const Point2DI& point) const;
+
+    Visibility GetVisibility(const Point2DI& point) const;
+
+    bool Contain(const Point2DI& point) const;
+};
+
 struct SampleImage {
     explicit SampleImage(const SC2APIProtocol::ImageData& data);
 
     explicit SampleImage(const ImageData& data);
 
+    explicit SampleImage(const ImageView& view);
+
     bool GetBit(const Point2DI& point, bool* dst) const;
 
     bool GetBit(const Point2DI& point, unsigned char* dst) const;
@@ -119,12 +147,8 @@ struct SampleImage {
     Rect2DI Area() const;
 
 private:
-    const std::string& data_;
+    ImageView image_;
     Rect2DI area_;
-
-    // NOTE (alkurbatov): Possible bits per pixel values specified in
-    // protocol/s2clientprotocol/raw.proto
-    int bits_per_pixel_;
 };
 
 struct PathingGrid {
@@ -160,4 +184,30 @@ private:
     SampleImage height_map_;
 };
 
+//! Pathing, placement and terrain height of a map decoded into dense grids. These never change during a game, so
+//! the grids are built once from GameInfo instead of sampling the packed images on every query.
+//! Cells are stored row-major, the value of a cell (x, y) is located at index x + y * width.
+struct StaticMapGrids {
+    int width;
+    int height;
+    //! 1 if a cell is pathable, 0 otherwise.
+    std::vector<uint8_t> pathing;
+    //! 1 if a cell is buildable, 0 otherwise.
+    std::vector<uint8_t> placement;
+    //! Terrain height of a cell in world units.
+    std::vector<float> terrain_height;
+
+    StaticMapGrids();
+
+    explicit StaticMapGrids(const GameInfo& info);
+
+    bool IsPathable(const Point2DI& point) const;
+
+    bool IsPlacable(const Point2DI& point) const;
+
+    float TerrainHeight(const Point2DI& point) const;
+
+    bool Contain(const Point2DI& point) const;
+};
+
 }  // namespace sc2
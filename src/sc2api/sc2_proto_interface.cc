@@ -1,6 +1,7 @@
 #include "sc2_proto_interface.h"
 
 #include <cassert>
+#include <fstream>
 #include <iostream>
 
 #include "sc2_control_interfaces.h"
@@ -92,7 +93,15 @@ ProtoInterface::ProtoInterface()
       port_(5000),
       default_timeout_ms_(kDefaultProtoInterfaceTimeout),
       latest_status_(SC2APIProtocol::Status::unknown),
-      response_pending_(SC2APIProtocol::Response::RESPONSE_NOT_SET) {
+      next_request_id_(1),
+      pipelining_(false),
+      stats_interval_(0) {
+}
+
+ProtoInterface::~ProtoInterface() {
+    if (!stats_path_.empty()) {
+        DumpStats(stats_path_);
+    }
 }
 
 bool ProtoInterface::ConnectToGame(const std::string& address, int port, int timeout_ms) {
@@ -113,51 +122,104 @@ GameRequestPtr ProtoInterface::MakeRequest() {
     return std::make_shared<SC2APIProtocol::Request>(SC2APIProtocol::Request());
 }
 
-bool ProtoInterface::SendRequest(GameRequestPtr& request, bool ignore_pending_requests) {
-    uint32_t request_type = static_cast<uint32_t>(request->request_case());
-    if (request_type >= count_uses_.size()) {
-        uint32_t current = static_cast<uint32_t>(count_uses_.size());
-        count_uses_.resize(request_type + 1);
-        for (uint32_t i = current; i < request_type + 1; ++i) {
-            count_uses_[i] = 0;
-        }
-    }
-    ++count_uses_[request_type];
+bool ProtoInterface::SendRequest(GameRequestPtr& request, bool ignore_pending_requests, bool await_response) {
+    RequestStats& stats = stats_.Get(request->request_case());
+    ++stats.count;
 
-    // If there is no connection, try rebuilding the connection.
-    if (!connection_.HasConnection()) {
+    // If there is no connection, try rebuilding the connection. Requests answered in process don't need one.
+    if (!request_handler_ && !connection_.HasConnection()) {
         if (!connection_.Connect(address_, port_, false)) {
             return false;
         }
     }
 
     // If there is still no connection, give up.
-    if (!connection_.HasConnection()) {
+    if (!request_handler_ && !connection_.HasConnection()) {
         return false;
     }
 
-    // Technically there can be new requests while responses are pending, but this library is not written for that.
-    // For now, make everything purely sequential.
-    if (!ignore_pending_requests && HasResponsePending()) {
+    // Unless pipelining, everything is purely sequential and a response must be consumed before the next request.
+    if (!ignore_pending_requests && !pipelining_ && HasResponsePending()) {
         control_->Error(ClientError::ResponseNotConsumed);
         return false;
     }
 
-    connection_.Send(request.get());
+    const uint32_t id = next_request_id_++;
+    request->set_id(id);
+    const std::chrono::steady_clock::time_point sent = std::chrono::steady_clock::now();
+    if (request_handler_) {
+        stats.bytes_sent += request->ByteSizeLong();
+        SC2APIProtocol::Response* response = request_handler_(*request);
+        if (!response) {
+            response = new SC2APIProtocol::Response();
+            response->add_error("The request handler didn't answer the request.");
+        }
+        response->set_id(id);
 
-    // Expect a certain response.
-    response_pending_ = SC2APIProtocol::Response::ResponseCase(request->request_case());
+        ResponseInfo info;
+        info.bytes = response->ByteSizeLong();
+        info.received = std::chrono::steady_clock::now();
+        if (!connection_.PushResponse(response, info)) {
+            return false;
+        }
+    } else {
+        connection_.Send(request.get());
+        // Sending serializes the request, which caches its size.
+        stats.bytes_sent += static_cast<uint64_t>(request->GetCachedSize());
+    }
+
+    // Expect a certain response, the game answers requests in the order they were sent.
+    pending_responses_.push_back(
+        {id, SC2APIProtocol::Response::ResponseCase(request->request_case()), await_response || !pipelining_, sent});
     return true;
 }
 
 GameResponsePtr ProtoInterface::WaitForResponseInternal() {
+    // Consume the acknowledgments of pipelined requests that were sent ahead of the awaited response. If none is
+    // awaited, the last acknowledgment is returned.
+    while (pending_responses_.size() > 1 && !pending_responses_.front().awaited) {
+        if (!ReceiveAcknowledgment()) {
+            return nullptr;
+        }
+    }
+
+    return ReceiveResponse();
+}
+
+bool ProtoInterface::ReceiveAcknowledgment() {
+    const GameResponsePtr acknowledgment = ReceiveResponse();
+    if (!acknowledgment) {
+        return false;
+    }
+
+    // Nobody waits for the acknowledgment, report its errors the way an awaited response reports them.
+    if (acknowledgment->error_size() > 0 && control_) {
+        std::vector<std::string> errors;
+        for (int i = 0; i < acknowledgment->error_size(); ++i) {
+            errors.push_back(acknowledgment->error(i));
+        }
+        control_->Error(ClientError::SC2ProtocolError, errors);
+    }
+
+    return true;
+}
+
+GameResponsePtr ProtoInterface::ReceiveResponse() {
     latest_status_ = SC2APIProtocol::Status::unknown;
-    SC2APIProtocol::Response* response = nullptr;
+    GameResponsePtr response;
     if (!connection_.Receive(response, default_timeout_ms_)) {
-        // If the receive fails, it means a timeout has occurred.
+        // If the receive fails, it means a timeout has occurred. The connection has been dropped along with any
+        // response still in flight.
+        pending_responses_.clear();
         return nullptr;
     }
 
+    PendingResponse pending = {0, SC2APIProtocol::Response::RESPONSE_NOT_SET, true, {}};
+    if (!pending_responses_.empty()) {
+        pending = pending_responses_.front();
+        RecordResponse(pending, connection_.GetLastResponseInfo());
+    }
+
     for (int i = 0; error_callback_ && response && i < response->error_size(); ++i) {
         error_callback_(response->error(i));
     }
@@ -167,23 +229,64 @@ GameResponsePtr ProtoInterface::WaitForResponseInternal() {
             latest_status_ = response->status();
         }
         if (response->error_size() > 0) {
-            std::cerr << "While waiting for Response" << RequestResponseIDToName(response_pending_)
+            std::cerr << "While waiting for Response" << RequestResponseIDToName(pending.response_case)
                       << " received an error." << std::endl;
             for (int i = 0; i < response->error_size(); ++i) {
                 std::cerr << "Error: " << response->error(i) << std::endl;
             }
         } else {
             SC2APIProtocol::Response::ResponseCase actual_response = response->response_case();
-            if (response_pending_ != actual_response) {
+            // Older game versions don't echo the id of the request.
+            if (pending.response_case != actual_response || (response->id() != 0 && response->id() != pending.id)) {
                 // This is bad, it means we did not get the response that matches the last request.
                 control_->Error(ClientError::ResponseMismatch);
             }
         }
     }
 
-    // No longer expecting a specific response.
-    response_pending_ = SC2APIProtocol::Response::RESPONSE_NOT_SET;
-    return GameResponsePtr(response);
+    // No longer expecting this response.
+    if (!pending_responses_.empty()) {
+        pending_responses_.pop_front();
+    }
+
+    return response;
+}
+
+void ProtoInterface::RecordResponse(const PendingResponse& pending, const ResponseInfo& info) {
+    RequestStats& stats = stats_.Get(pending.response_case);
+    stats.bytes_received += info.bytes;
+    stats.parse_us.Record(info.parse_us);
+    if (info.received > pending.sent) {
+        stats.latency_us.Record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(info.received - pending.sent).count()));
+    } else {
+        stats.latency_us.Record(0);
+    }
+
+    if (!stats_path_.empty() && info.received - stats_dumped_ >= stats_interval_) {
+        stats_dumped_ = info.received;
+        DumpStats(stats_path_);
+    }
+}
+
+void ProtoInterface::ResetStats() {
+    stats_.Reset();
+}
+
+void ProtoInterface::SetStatsDump(const std::string& path, unsigned int interval_ms) {
+    stats_path_ = path;
+    stats_interval_ = std::chrono::milliseconds(interval_ms);
+    stats_dumped_ = std::chrono::steady_clock::now();
+}
+
+bool ProtoInterface::DumpStats(const std::string& path) const {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+
+    file << stats_.ToJson();
+    return static_cast<bool>(file);
 }
 
 bool ProtoInterface::PingGame() {
@@ -218,16 +321,67 @@ void ProtoInterface::Quit() {
     connection_.Disconnect();
 }
 
+void ProtoInterface::SetUseResponseArenas(bool value) {
+    connection_.SetUseResponseArenas(value);
+}
+
+void ProtoInterface::SetRequestHandler(
+    std::function<SC2APIProtocol::Response*(const SC2APIProtocol::Request&)> request_handler) {
+    request_handler_ = request_handler;
+}
+
+bool ProtoInterface::StartCapture(const std::string& path) {
+    return connection_.StartCapture(path);
+}
+
+void ProtoInterface::StopCapture() {
+    connection_.StopCapture();
+}
+
+bool ProtoInterface::IsCapturing() const {
+    return connection_.IsCapturing();
+}
+
 void ProtoInterface::SetErrorCallback(std::function<void(const std::string& error_str)> error_callback) {
     error_callback_ = error_callback;
 }
 
 bool ProtoInterface::PollResponse() {
-    return connection_.PollResponse();
+    if (pending_responses_.empty()) {
+        return connection_.PollResponse();
+    }
+
+    // Acknowledgments of pipelined requests that already arrived are consumed without blocking, only the awaited
+    // response counts as ready.
+    while (pending_responses_.size() > 1 && !pending_responses_.front().awaited && connection_.PollResponse()) {
+        if (!ReceiveAcknowledgment()) {
+            return false;
+        }
+    }
+
+    return !pending_responses_.empty() && connection_.PollResponse();
 }
 
 bool ProtoInterface::HasResponsePending() const {
-    return response_pending_ != SC2APIProtocol::Response::ResponseCase::RESPONSE_NOT_SET;
+    return GetResponsePending() != SC2APIProtocol::Response::RESPONSE_NOT_SET;
+}
+
+void ProtoInterface::DiscardPendingResponses() {
+    pending_responses_.clear();
+}
+
+SC2APIProtocol::Response::ResponseCase ProtoInterface::GetResponsePending() const {
+    for (const PendingResponse& pending : pending_responses_) {
+        if (pending.awaited) {
+            return pending.response_case;
+        }
+    }
+
+    return SC2APIProtocol::Response::RESPONSE_NOT_SET;
+}
+
+void ProtoInterface::SetPipelining(bool value) {
+    pipelining_ = value;
 }
 
 }  // namespace sc2
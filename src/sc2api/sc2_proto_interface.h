@@ -1,9 +1,13 @@
 #pragma once
 
+#include <chrono>
+#include <deque>
 #include <functional>
+#include <string>
 
 #include "s2clientprotocol/sc2api.pb.h"
 #include "sc2_connection.h"
+#include "sc2_proto_stats.h"
 
 namespace sc2 {
 
@@ -11,9 +15,6 @@ class ControlInterface;
 
 const unsigned int kDefaultProtoInterfaceTimeout = 120000;  // A generous 120 seconds.
 
-typedef std::shared_ptr<SC2APIProtocol::Request> GameRequestPtr;
-typedef std::shared_ptr<const SC2APIProtocol::Response> GameResponsePtr;
-
 template <class MessageType>
 class MessageResponsePtr {
 public:
@@ -83,28 +84,60 @@ private:
 class ProtoInterface {
 public:
     ProtoInterface();
+    ~ProtoInterface();
     bool ConnectToGame(const std::string& address, int port, int timeout_ms);
     GameRequestPtr MakeRequest();
-    bool SendRequest(GameRequestPtr& request, bool ignore_pending_requests = false);
+    // Requests sent with await_response set to false only get an acknowledgment back, with pipelining enabled it is
+    // consumed while waiting for the next awaited response instead of costing a round trip of its own.
+    bool SendRequest(GameRequestPtr& request, bool ignore_pending_requests = false, bool await_response = true);
     GameResponsePtr WaitForResponseInternal();
     bool PingGame();
     void Quit();
+    void SetUseResponseArenas(bool value);
     void SetErrorCallback(std::function<void(const std::string& error_str)> error_callback);
+    // Whether the awaited response has arrived. Acknowledgments of pipelined requests queued ahead of it are
+    // consumed on the way.
     bool PollResponse();
     SC2APIProtocol::Status GetLastStatus() const {
         return latest_status_;
     }
+    // Whether a response is waited for. Pipelined acknowledgments don't count, they are consumed with the next awaited
+    // response.
     bool HasResponsePending() const;
-    SC2APIProtocol::Response::ResponseCase GetResponsePending() const {
-        return response_pending_;
-    }
+    // The type of the oldest response that is waited for.
+    SC2APIProtocol::Response::ResponseCase GetResponsePending() const;
+    size_t GetPendingResponseCount() const {
+        return pending_responses_.size();
+    }
+    // Stops expecting the responses still pending, e.g. once the game stopped responding and they won't arrive.
+    void DiscardPendingResponses();
+    // Lets requests be sent while earlier responses are still pending. Requests are tagged with an id and responses are
+    // matched to them in the order the requests were sent.
+    void SetPipelining(bool value);
+    bool IsPipelining() const {
+        return pipelining_;
+    }
+    // Answers requests in process instead of sending them to the game, e.g. to run the client against recorded
+    // responses without a game. The handler returns a response allocated with new, the interface takes ownership.
+    void SetRequestHandler(std::function<SC2APIProtocol::Response*(const SC2APIProtocol::Request&)> request_handler);
+    // Records the requests sent and the responses received over the connection to a capture file, read it back with
+    // CaptureReader. Requests answered by the request handler aren't recorded.
+    bool StartCapture(const std::string& path);
+    void StopCapture();
+    bool IsCapturing() const;
     int GetAssignedPort() const {
         return port_;
     }
 
-    const std::vector<uint32_t>& GetStats() const {
-        return count_uses_;
+    // Counts, sizes and latencies of the requests sent so far, by request type.
+    const ProtoStats& GetStats() const {
+        return stats_;
     }
+    void ResetStats();
+    // Rewrites the statistics as JSON to a file, at most every interval while responses are received and once more
+    // when the interface is destroyed. An empty path stops writing them.
+    void SetStatsDump(const std::string& path, unsigned int interval_ms);
+    bool DumpStats(const std::string& path) const;
     void SetControl(ControlInterface* control) {
         control_ = control;
     }
@@ -117,14 +150,32 @@ public:
     }
 
 protected:
+    struct PendingResponse {
+        uint32_t id;
+        SC2APIProtocol::Response::ResponseCase response_case;
+        bool awaited;
+        std::chrono::steady_clock::time_point sent;
+    };
+
+    GameResponsePtr ReceiveResponse();
+    // Receives the acknowledgment of a pipelined request and reports its errors, false if the connection failed.
+    bool ReceiveAcknowledgment();
+    void RecordResponse(const PendingResponse& pending, const ResponseInfo& info);
+
     Connection connection_;
     std::string address_;
     int port_;
     unsigned int default_timeout_ms_;
     std::function<void(const std::string& error_str)> error_callback_;
+    std::function<SC2APIProtocol::Response*(const SC2APIProtocol::Request&)> request_handler_;
     SC2APIProtocol::Status latest_status_;
-    SC2APIProtocol::Response::ResponseCase response_pending_;
-    std::vector<uint32_t> count_uses_;
+    std::deque<PendingResponse> pending_responses_;
+    uint32_t next_request_id_;
+    bool pipelining_;
+    ProtoStats stats_;
+    std::string stats_path_;
+    std::chrono::milliseconds stats_interval_;
+    std::chrono::steady_clock::time_point stats_dumped_;
     ControlInterface* control_;
 
     uint32_t base_build_;
@@ -0,0 +1,146 @@
+#include "sc2_proto_stats.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "sc2_proto_interface.h"
+
+namespace sc2 {
+
+namespace {
+
+// Values below 2^kPrecisionBits are counted exactly, larger ones by their top kPrecisionBits bits.
+const int kPrecisionBits = 7;
+const uint64_t kExactValues = 1ULL << kPrecisionBits;
+const uint64_t kHalfExactValues = kExactValues / 2;
+
+int HighestBit(uint64_t value) {
+    int bit = 0;
+    while (value >>= 1) {
+        ++bit;
+    }
+
+    return bit;
+}
+
+size_t GetBucket(uint64_t value) {
+    if (value < kExactValues) {
+        return static_cast<size_t>(value);
+    }
+
+    // Every power of two past the exact values is split in kHalfExactValues buckets.
+    const int shift = HighestBit(value) - (kPrecisionBits - 1);
+    return static_cast<size_t>(shift * kHalfExactValues + (value >> shift));
+}
+
+// The largest value counted in the bucket.
+uint64_t GetBucketValue(size_t bucket) {
+    if (bucket < kExactValues) {
+        return bucket;
+    }
+
+    const int shift = static_cast<int>(bucket / kHalfExactValues) - 1;
+    const uint64_t mantissa = bucket - shift * kHalfExactValues;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void WriteHistogram(std::ostringstream& json, const char* name, const LatencyHistogram& histogram) {
+    json << "\"" << name << "\": {\"count\": " << histogram.GetCount() << ", \"min\": " << histogram.GetMin()
+         << ", \"mean\": " << histogram.GetMean() << ", \"p50\": " << histogram.GetPercentile(50.0)
+         << ", \"p90\": " << histogram.GetPercentile(90.0) << ", \"p99\": " << histogram.GetPercentile(99.0)
+         << ", \"max\": " << histogram.GetMax() << "}";
+}
+
+}  // namespace
+
+void LatencyHistogram::Record(uint64_t value) {
+    const size_t bucket = GetBucket(value);
+    if (bucket >= counts_.size()) {
+        counts_.resize(bucket + 1, 0);
+    }
+
+    ++counts_[bucket];
+    min_ = count_ == 0 ? value : std::min(min_, value);
+    max_ = std::max(max_, value);
+    sum_ += static_cast<double>(value);
+    ++count_;
+}
+
+double LatencyHistogram::GetMean() const {
+    return count_ > 0 ? sum_ / count_ : 0.0;
+}
+
+uint64_t LatencyHistogram::GetPercentile(double percentile) const {
+    if (count_ == 0) {
+        return 0;
+    }
+
+    const double clamped = std::min(std::max(percentile, 0.0), 100.0);
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(clamped / 100.0 * count_ + 0.5));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < counts_.size(); ++bucket) {
+        seen += counts_[bucket];
+        if (seen >= rank) {
+            // The bucket bound may overshoot the values actually recorded.
+            return std::min(std::max(GetBucketValue(bucket), min_), max_);
+        }
+    }
+
+    return max_;
+}
+
+void LatencyHistogram::Reset() {
+    counts_.clear();
+    count_ = 0;
+    min_ = 0;
+    max_ = 0;
+    sum_ = 0.0;
+}
+
+RequestStats& ProtoStats::Get(int type) {
+    const size_t index = static_cast<size_t>(std::max(type, 0));
+    if (index >= requests.size()) {
+        requests.resize(index + 1);
+    }
+
+    return requests[index];
+}
+
+const RequestStats* ProtoStats::Find(int type) const {
+    if (type < 0 || static_cast<size_t>(type) >= requests.size() || requests[type].count == 0) {
+        return nullptr;
+    }
+
+    return &requests[type];
+}
+
+void ProtoStats::Reset() {
+    requests.clear();
+}
+
+std::string ProtoStats::ToJson() const {
+    std::ostringstream json;
+    json << "{\"requests\": [";
+
+    bool first = true;
+    for (size_t type = 0; type < requests.size(); ++type) {
+        const RequestStats& stats = requests[type];
+        if (stats.count == 0) {
+            continue;
+        }
+
+        json << (first ? "\n" : ",\n");
+        json << "  {\"type\": \"" << RequestResponseIDToName(static_cast<int>(type)) << "\", \"count\": " << stats.count
+             << ", \"bytes_sent\": " << stats.bytes_sent << ", \"bytes_received\": " << stats.bytes_received << ", ";
+        WriteHistogram(json, "latency_us", stats.latency_us);
+        json << ", ";
+        WriteHistogram(json, "parse_us", stats.parse_us);
+        json << "}";
+        first = false;
+    }
+
+    json << (first ? "" : "\n") << "]}\n";
+    return json.str();
+}
+
+}  // namespace sc2
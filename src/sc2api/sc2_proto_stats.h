@@ -0,0 +1,90 @@
+/*! \file sc2_proto_stats.h
+    \brief Latency and traffic statistics of the requests sent to the game.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sc2 {
+
+//! Histogram of positive integer values with logarithmic buckets, in the spirit of HDR histograms. Values are kept with
+//! a relative error below 1/64 whatever their magnitude, and recording a value is a couple of bit operations.
+class LatencyHistogram {
+public:
+    //! Adds a value to the histogram.
+    //!< \param value The value to add.
+    void Record(uint64_t value);
+
+    //! Number of values recorded.
+    uint64_t GetCount() const {
+        return count_;
+    }
+
+    //! Smallest value recorded, 0 if none was.
+    uint64_t GetMin() const {
+        return min_;
+    }
+
+    //! Largest value recorded, 0 if none was.
+    uint64_t GetMax() const {
+        return max_;
+    }
+
+    //! Average of the values recorded, 0 if none was.
+    double GetMean() const;
+
+    //! The value below or at which the given share of the values lies, within the precision of the histogram.
+    //!< \param percentile The share of the values, between 0 and 100.
+    //!< \return The percentile, 0 if no value was recorded.
+    uint64_t GetPercentile(double percentile) const;
+
+    //! Forgets all values recorded.
+    void Reset();
+
+private:
+    std::vector<uint64_t> counts_;
+    uint64_t count_ = 0;
+    uint64_t min_ = 0;
+    uint64_t max_ = 0;
+    double sum_ = 0.0;
+};
+
+//! Statistics of the requests of one type.
+struct RequestStats {
+    //! Requests sent.
+    uint64_t count = 0;
+    //! Size of the requests sent, in bytes.
+    uint64_t bytes_sent = 0;
+    //! Size of the responses received, in bytes.
+    uint64_t bytes_received = 0;
+    //! Time from sending a request until its response arrived off the socket, in microseconds.
+    LatencyHistogram latency_us;
+    //! Time spent parsing the responses, in microseconds.
+    LatencyHistogram parse_us;
+};
+
+//! Statistics of the traffic between a client and the game, by request type.
+struct ProtoStats {
+    //! Statistics indexed by request type, see RequestResponseIDToName for their names. Grows as new types are sent.
+    std::vector<RequestStats> requests;
+
+    //! Statistics of the requests of a type, created on first use.
+    //!< \param type The request case of the requests.
+    RequestStats& Get(int type);
+
+    //! Statistics of the requests of a type.
+    //!< \param type The request case of the requests.
+    //!< \return Null if no request of the type was sent.
+    const RequestStats* Find(int type) const;
+
+    //! Forgets all statistics.
+    void Reset();
+
+    //! Serializes the statistics of the request types that were sent as a JSON document.
+    std::string ToJson() const;
+};
+
+}  // namespace sc2
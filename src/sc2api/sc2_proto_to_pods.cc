@@ -1,8 +1,11 @@
 #include "sc2_proto_to_pods.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <utility>
 
+#include "sc2_data.h"
 #include "sc2_unit_filters.h"
 
 namespace sc2 {
@@ -185,8 +188,13 @@ bool Convert(const SC2APIProtocol::CloakState& cloak_proto, Unit::CloakState& cl
     return false;
 }
 
+// The progress changes every step while an order is carried out, it isn't considered a change of the order.
+static bool IsSameOrder(const UnitOrder& a, const UnitOrder& b) {
+    return a.ability_id == b.ability_id && a.target_unit_tag == b.target_unit_tag && a.target_pos == b.target_pos;
+}
+
 bool Convert(const ObservationRawPtr& observation_raw, UnitPool& unit_pool, uint32_t game_loop,
-             uint32_t prev_game_loop) {
+             uint32_t prev_game_loop, const ObservationInterface* generalize_abilities) {
     for (int i = 0; i < observation_raw->units_size(); ++i) {
         const SC2APIProtocol::Unit& observation_unit = observation_raw->units(i);
         Unit* unit = unit_pool.CreateUnit(observation_unit.tag());
@@ -195,9 +203,14 @@ bool Convert(const ObservationRawPtr& observation_raw, UnitPool& unit_pool, uint
             continue;
         }
 
+        uint32_t changed = Unit::ChangedNone;
+        const Unit::DisplayType display_type = unit->display_type;
         if (!Convert(observation_unit.display_type(), unit->display_type)) {
             return false;
         }
+        if (unit->display_type != display_type) {
+            changed |= Unit::ChangedDisplayType;
+        }
         if (!Convert(observation_unit.alliance(), unit->alliance)) {
             return false;
         }
@@ -207,9 +220,11 @@ bool Convert(const ObservationRawPtr& observation_raw, UnitPool& unit_pool, uint
         unit->owner = observation_unit.owner();
 
         const SC2APIProtocol::Point& pt = observation_unit.pos();
-        unit->pos.x = pt.x();
-        unit->pos.y = pt.y();
-        unit->pos.z = pt.z();
+        const Point3D pos(pt.x(), pt.y(), pt.z());
+        if (unit->pos != pos) {
+            changed |= Unit::ChangedPosition;
+            unit->pos = pos;
+        }
         unit->facing = observation_unit.facing();
         unit->radius = observation_unit.radius();
 
@@ -218,7 +233,10 @@ bool Convert(const ObservationRawPtr& observation_raw, UnitPool& unit_pool, uint
             unit_pool.AddCompletedBuilding(unit);
             unit_pool.AddUnitIdled(unit);
         }
-        unit->build_progress = bp;
+        if (unit->build_progress != bp) {
+            changed |= Unit::ChangedBuildProgress;
+            unit->build_progress = bp;
+        }
 
         if (observation_unit.has_cloak()) {
             if (!Convert(observation_unit.cloak(), unit->cloak)) {
@@ -246,6 +264,16 @@ bool Convert(const ObservationRawPtr& observation_raw, UnitPool& unit_pool, uint
         if (damage > 0 || shield_damage > 0)
             unit_pool.AddUnitDamaged(unit, damage, shield_damage);
 
+        if (damage != 0 || unit->health_max != observation_unit.health_max()) {
+            changed |= Unit::ChangedHealth;
+        }
+        if (shield_damage != 0 || unit->shield_max != observation_unit.shield_max()) {
+            changed |= Unit::ChangedShield;
+        }
+        if (unit->energy != observation_unit.energy() || unit->energy_max != observation_unit.energy_max()) {
+            changed |= Unit::ChangedEnergy;
+        }
+
         unit->health_max = observation_unit.health_max();
         unit->shield_max = observation_unit.shield_max();
         unit->energy = observation_unit.energy();
@@ -259,18 +287,31 @@ bool Convert(const ObservationRawPtr& observation_raw, UnitPool& unit_pool, uint
         unit->weapon_cooldown = observation_unit.weapon_cooldown();
         unit->engaged_target_tag = observation_unit.engaged_target_tag();
 
+        // The orders are overwritten in place so that they can be compared to the previous ones.
         bool hadOrders = !unit->orders.empty();
-        unit->orders.clear();
+        const size_t orders_size = static_cast<size_t>(observation_unit.orders_size());
+        if (unit->orders.size() != orders_size) {
+            changed |= Unit::ChangedOrders;
+            unit->orders.resize(orders_size);
+        }
         for (int order_index = 0; order_index < observation_unit.orders_size(); ++order_index) {
             const SC2APIProtocol::UnitOrder& order_proto = observation_unit.orders(order_index);
 
             UnitOrder order;
             order.ability_id = order_proto.ability_id();
+            if (generalize_abilities) {
+                order.ability_id = GetGeneralizedAbilityID(order.ability_id, *generalize_abilities);
+            }
             order.target_unit_tag = order_proto.target_unit_tag();
             order.target_pos.x = order_proto.target_world_space_pos().x();
             order.target_pos.y = order_proto.target_world_space_pos().y();
             order.progress = order_proto.progress();
-            unit->orders.push_back(order);
+
+            UnitOrder& unit_order = unit->orders[order_index];
+            if (!IsSameOrder(unit_order, order)) {
+                changed |= Unit::ChangedOrders;
+            }
+            unit_order = order;
         }
         if (hadOrders && unit->orders.empty())
             unit_pool.AddUnitIdled(unit);
@@ -305,9 +346,17 @@ bool Convert(const ObservationRawPtr& observation_raw, UnitPool& unit_pool, uint
         unit->assigned_harvesters = observation_unit.assigned_harvesters();
         unit->ideal_harvesters = observation_unit.ideal_harvesters();
 
-        unit->buffs.clear();
+        const size_t buffs_size = static_cast<size_t>(observation_unit.buff_ids_size());
+        if (unit->buffs.size() != buffs_size) {
+            changed |= Unit::ChangedBuffs;
+            unit->buffs.resize(buffs_size);
+        }
         for (int buff_index = 0; buff_index < observation_unit.buff_ids_size(); ++buff_index) {
-            unit->buffs.push_back(observation_unit.buff_ids(buff_index));
+            const BuffID buff = observation_unit.buff_ids(buff_index);
+            if (unit->buffs[buff_index] != buff) {
+                changed |= Unit::ChangedBuffs;
+                unit->buffs[buff_index] = buff;
+            }
         }
 
         unit->is_powered = observation_unit.is_powered();
@@ -321,6 +370,11 @@ bool Convert(const ObservationRawPtr& observation_raw, UnitPool& unit_pool, uint
         unit->shield_upgrade_level = observation_unit.shield_upgrade_level();
 
         unit->is_building = IsBuilding()(unit->unit_type);
+
+        unit->changed_fields |= changed;
+        if (unit->changed_fields != Unit::ChangedNone) {
+            unit_pool.AddUnitChanged(unit);
+        }
     }
 
     return true;
@@ -336,6 +390,73 @@ bool Convert(const SC2APIProtocol::ImageData& image, ImageData& data) {
     return expectedSizeBits > 0 && data.data.size() * 8 == expectedSizeBits;
 }
 
+bool Convert(const SC2APIProtocol::ImageData& image, std::shared_ptr<const void> owner, ImageView& view) {
+    view = ImageView(image);
+    if (!view.IsValid()) {
+        return false;
+    }
+
+    view.owner = std::move(owner);
+    return true;
+}
+
+// Unpacks 1 bpp and 8 bpp images into one byte per cell, cells not covered by the image are set to 0.
+static void UnpackImage(const SC2APIProtocol::ImageData& image, int width, int height, std::vector<uint8_t>& cells) {
+    cells.assign(static_cast<size_t>(width) * height, 0);
+
+    const std::string& data = image.data();
+    const int image_width = image.size().x();
+    const int columns = std::min(width, image_width);
+    const int rows = std::min(height, image.size().y());
+
+    if (image.bits_per_pixel() == 1) {
+        for (int y = 0; y < rows; ++y) {
+            for (int x = 0; x < columns; ++x) {
+                const size_t idx = static_cast<size_t>(x) + static_cast<size_t>(y) * image_width;
+                if (idx / 8 >= data.size())
+                    return;
+
+                cells[x + y * width] = (data[idx / 8] >> (7 - idx % 8)) & 1;
+            }
+        }
+
+        return;
+    }
+
+    if (image.bits_per_pixel() != 8)
+        return;
+
+    for (int y = 0; y < rows; ++y) {
+        const size_t offset = static_cast<size_t>(y) * image_width;
+        if (offset >= data.size())
+            return;
+
+        const size_t count = std::min(static_cast<size_t>(columns), data.size() - offset);
+        std::copy_n(data.data() + offset, count, cells.begin() + static_cast<size_t>(y) * width);
+    }
+}
+
+bool Convert(const ObservationRawPtr& observation_raw, MapState& map_state) {
+    const SC2APIProtocol::MapState& map_state_proto = observation_raw->map_state();
+    const SC2APIProtocol::ImageData& visibility = map_state_proto.visibility();
+
+    map_state.width = std::max(visibility.size().x(), 0);
+    map_state.height = std::max(visibility.size().y(), 0);
+
+    UnpackImage(visibility, map_state.width, map_state.height, map_state.visibility);
+    for (uint8_t& value : map_state.visibility) {
+        if (value > static_cast<uint8_t>(Visibility::Visible))
+            value = static_cast<uint8_t>(Visibility::FullHidden);
+    }
+
+    UnpackImage(map_state_proto.creep(), map_state.width, map_state.height, map_state.creep);
+    for (uint8_t& value : map_state.creep) {
+        value = value > 0 ? 1 : 0;
+    }
+
+    return map_state.width > 0 && map_state.height > 0;
+}
+
 bool Convert(const ObservationPtr& observation_ptr, RenderedFrame& render) {
     ObservationRenderPtr observation_render;
     SET_SUBMESSAGE_RESPONSE(observation_render, observation_ptr, render_data);
@@ -362,6 +483,22 @@ bool Convert(const ObservationPtr& observation_ptr, RenderedFrame& render) {
     return true;
 }
 
+bool Convert(const ObservationPtr& observation_ptr, RenderedFrameView& render) {
+    ObservationRenderPtr observation_render;
+    SET_SUBMESSAGE_RESPONSE(observation_render, observation_ptr, render_data);
+    if (observation_render.HasErrors()) {
+        return false;
+    }
+
+    if (!observation_render->has_map() || !observation_render->has_minimap()) {
+        return false;
+    }
+
+    const GameResponsePtr response = observation_render.GetResponse();
+    return Convert(observation_render->map(), response, render.map) &&
+           Convert(observation_render->minimap(), response, render.minimap);
+}
+
 void ConvertRawActions(const ResponseObservationPtr& response_observation_ptr, RawActions& actions) {
     for (int i = 0; i < response_observation_ptr->actions_size(); ++i) {
         const SC2APIProtocol::Action& proto_action = response_observation_ptr->actions(i);
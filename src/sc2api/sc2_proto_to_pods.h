@@ -17,9 +17,15 @@ typedef MessageResponsePtr<SC2APIProtocol::ResponseGameInfo> ResponseGameInfoPtr
 typedef MessageResponsePtr<SC2APIProtocol::ResponseQuery> ResponseQueryPtr;
 
 bool Convert(const ObservationPtr& observation_ptr, Score& score);
+// Updates the units of the pool and records which of their fields changed. The abilities of the unit orders are
+// generalized with the ability data of the observation, if given, before being compared to the previous ones.
 bool Convert(const ObservationRawPtr& observation_ptr, UnitPool& unit_pool, uint32_t game_loop,
-             uint32_t prev_game_loop);
+             uint32_t prev_game_loop, const ObservationInterface* generalize_abilities = nullptr);
+bool Convert(const ObservationRawPtr& observation_ptr, MapState& map_state);
 bool Convert(const ObservationPtr& observation_ptr, RenderedFrame& render);
+bool Convert(const ObservationPtr& observation_ptr, RenderedFrameView& render);
+// Views the pixels of an image without copying them, the owner keeps them alive.
+bool Convert(const SC2APIProtocol::ImageData& image, std::shared_ptr<const void> owner, ImageView& view);
 bool Convert(const ResponseGameInfoPtr& response_game_info_ptr, GameInfo& game_info);
 
 void ConvertRawActions(const ResponseObservationPtr& response_observation_ptr, RawActions& actions);
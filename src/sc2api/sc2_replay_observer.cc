@@ -6,6 +6,7 @@
 #include "sc2_game_settings.h"
 #include "sc2_interfaces.h"
 #include "sc2_proto_to_pods.h"
+#include "sc2utils/sc2_trace.h"
 
 namespace sc2 {
 
@@ -226,6 +227,7 @@ bool ReplayControlImp::WaitForReplay() {
         return true;
     }
 
+    control_interface_->ResetUnits();
     control_interface_->GetObservation();
     replay_observer_->Control()->OnGameStart();
     replay_observer_->OnGameStart();
@@ -288,16 +290,20 @@ void ObserverActionImp::CameraFollowPlayer() {
 }
 
 void ObserverActionImp::SendActions() {
+    SC2_TRACE_SCOPE("ObserverActionImp::SendActions");
     if (request_ == nullptr) {
         return;
     }
 
-    if (!control_->Proto().SendRequest(request_)) {
+    const bool await_response = !control_->Proto().IsPipelining();
+    if (!control_->Proto().SendRequest(request_, false, await_response)) {
         return;
     }
 
     request_ = nullptr;
-    control_->WaitForResponse();
+    if (await_response) {
+        control_->WaitForResponse();
+    }
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -1,10 +1,12 @@
 #include "sc2_server.h"
 
+#include <chrono>
 #include <cstring>
 #include <iostream>
 
 #include "civetweb.h"
 #include "s2clientprotocol/sc2api.pb.h"
+#include "sc2_connection.h"
 
 namespace sc2 {
 
@@ -74,7 +76,7 @@ static void WebSocketCloseHandler(const mg_connection* conn, void* websocket_ser
 }
 
 template <class T>
-static void SendMessage(mg_connection* conn, std::queue<T>& message_queue) {
+static void SendMessage(mg_connection* conn, std::queue<T>& message_queue, std::vector<char>& buffer) {
     if (message_queue.empty()) {
         return;
     }
@@ -83,12 +85,9 @@ static void SendMessage(mg_connection* conn, std::queue<T>& message_queue) {
         std::cout << "SendMessage (" << conn << ")" << std::endl;
 
     google::protobuf::Message* message = message_queue.front().second;
-    size_t size = message->ByteSizeLong();
-    char* bytes = new char[size];
-    message->SerializeToArray(bytes, (int)size);
-    mg_websocket_write(conn, MG_WEBSOCKET_OPCODE_BINARY, (const char*)bytes, size);
+    const size_t size = SerializeToBuffer(*message, buffer);
+    mg_websocket_write(conn, MG_WEBSOCKET_OPCODE_BINARY, buffer.data(), size);
     message_queue.pop();
-    delete[] bytes;
     delete message;
 }
 
@@ -128,6 +127,7 @@ void Server::QueueRequest(struct mg_connection* conn, SC2APIProtocol::Request*&
     request_mutex_.lock();
     requests_.push(RequestData(conn, request));
     request_mutex_.unlock();
+    request_condition_.notify_one();
 }
 
 void Server::QueueResponse(struct mg_connection* conn, SC2APIProtocol::Response*& response) {
@@ -138,13 +138,19 @@ void Server::QueueResponse(struct mg_connection* conn, SC2APIProtocol::Response*
 
 void Server::SendRequest(struct mg_connection* conn) {
     request_mutex_.lock();
-    SendMessage(conn ? conn : (mg_connection*)connections_.front(), requests_);
+    SendMessage(conn ? conn : (mg_connection*)connections_.front(), requests_, request_buffer_);
     request_mutex_.unlock();
 }
 
 void Server::SendResponse(struct mg_connection* conn) {
     response_mutex_.lock();
-    SendMessage(conn ? conn : (mg_connection*)connections_.front(), responses_);
+    SendMessage(conn ? conn : (mg_connection*)connections_.front(), responses_, response_buffer_);
+    response_mutex_.unlock();
+}
+
+void Server::SendResponse(struct mg_connection* conn, const char* data, size_t size) {
+    response_mutex_.lock();
+    mg_websocket_write(conn ? conn : (mg_connection*)connections_.front(), MG_WEBSOCKET_OPCODE_BINARY, data, size);
     response_mutex_.unlock();
 }
 
@@ -162,6 +168,22 @@ bool Server::HasResponse() {
     return !empty;
 }
 
+bool Server::WaitForRequest(unsigned int timeout_ms) {
+    std::unique_lock<std::mutex> lock(request_mutex_);
+    return request_condition_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&] { return !requests_.empty(); });
+}
+
+bool Server::PopRequest(RequestData& request) {
+    request_mutex_.lock();
+    const bool empty = requests_.empty();
+    if (!empty) {
+        request = requests_.front();
+        requests_.pop();
+    }
+    request_mutex_.unlock();
+    return !empty;
+}
+
 const RequestData& Server::PeekRequest() {
     return requests_.front();
 }
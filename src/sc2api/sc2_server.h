@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <mutex>
 #include <queue>
 #include <utility>
@@ -36,9 +37,18 @@ public:
     void SendRequest(struct mg_connection* conn = nullptr);
     void SendResponse(struct mg_connection* conn = nullptr);
 
+    // Sends a response that is already serialized, bypassing the response queue.
+    void SendResponse(struct mg_connection* conn, const char* data, size_t size);
+
     bool HasRequest();
     bool HasResponse();
 
+    // Blocks until a request is queued or the timeout expires, returns whether a request is queued.
+    bool WaitForRequest(unsigned int timeout_ms);
+
+    // Takes the oldest request off the queue, the caller owns the request and has to delete it.
+    bool PopRequest(RequestData& request);
+
     const RequestData& PeekRequest();
     const ResponseData& PeekResponse();
 
@@ -52,6 +62,11 @@ private:
 
     std::mutex request_mutex_;
     std::mutex response_mutex_;
+    std::condition_variable request_condition_;
+
+    // Serialization buffers reused between messages, guarded by the mutex of the matching queue.
+    std::vector<char> request_buffer_;
+    std::vector<char> response_buffer_;
 };
 
 }  // namespace sc2
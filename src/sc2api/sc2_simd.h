@@ -0,0 +1,18 @@
+#pragma once
+
+// Helpers of the translation units with vectorized kernels, not part of the API.
+//
+// The kernels of every instruction set are compiled into the library whatever the compiler flags, the fastest one the
+// processor supports is picked at run time through GetSimdLevel. SSE2 is part of any x64 target, AVX2 functions are
+// marked with SC2_TARGET_AVX2 so that the compiler emits them without -mavx2.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SC2_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#if defined(SC2_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SC2_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SC2_TARGET_AVX2
+#endif
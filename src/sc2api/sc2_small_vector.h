@@ -0,0 +1,335 @@
+/*! \file sc2_small_vector.h
+    \brief A vector that stores its first elements inline.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace sc2 {
+
+//! A vector with room for N elements inside the object itself, it only allocates once it grows past N elements. Meant
+//! for the short lists held by every unit, e.g. its orders, which most units keep under a handful of elements. Offers
+//! the interface of std::vector that these lists are used with; iterators are pointers and, as with std::vector, are
+//! invalidated when the vector grows.
+template <class T, size_t N>
+class SmallVector {
+    static_assert(N > 0, "Use std::vector for lists without inline storage.");
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    //! Number of elements stored without allocating.
+    static constexpr size_t kInlineCapacity = N;
+
+    SmallVector() : data_(InlineData()), size_(0), capacity_(N) {
+    }
+
+    explicit SmallVector(size_t count) : SmallVector() {
+        resize(count);
+    }
+
+    SmallVector(size_t count, const T& value) : SmallVector() {
+        resize(count, value);
+    }
+
+    SmallVector(std::initializer_list<T> values) : SmallVector() {
+        assign(values.begin(), values.end());
+    }
+
+    template <class Iterator, class = typename std::iterator_traits<Iterator>::iterator_category>
+    SmallVector(Iterator first, Iterator last) : SmallVector() {
+        assign(first, last);
+    }
+
+    SmallVector(const SmallVector& other) : SmallVector() {
+        assign(other.begin(), other.end());
+    }
+
+    SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible<T>::value) : SmallVector() {
+        MoveFrom(other);
+    }
+
+    ~SmallVector() {
+        clear();
+        Deallocate();
+    }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept(std::is_nothrow_move_constructible<T>::value) {
+        if (this != &other) {
+            clear();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(std::initializer_list<T> values) {
+        assign(values.begin(), values.end());
+        return *this;
+    }
+
+    template <class Iterator, class = typename std::iterator_traits<Iterator>::iterator_category>
+    void assign(Iterator first, Iterator last) {
+        clear();
+        for (; first != last; ++first) {
+            emplace_back(*first);
+        }
+    }
+
+    iterator begin() noexcept {
+        return data_;
+    }
+    const_iterator begin() const noexcept {
+        return data_;
+    }
+    const_iterator cbegin() const noexcept {
+        return data_;
+    }
+    iterator end() noexcept {
+        return data_ + size_;
+    }
+    const_iterator end() const noexcept {
+        return data_ + size_;
+    }
+    const_iterator cend() const noexcept {
+        return data_ + size_;
+    }
+    reverse_iterator rbegin() noexcept {
+        return reverse_iterator(end());
+    }
+    const_reverse_iterator rbegin() const noexcept {
+        return const_reverse_iterator(end());
+    }
+    reverse_iterator rend() noexcept {
+        return reverse_iterator(begin());
+    }
+    const_reverse_iterator rend() const noexcept {
+        return const_reverse_iterator(begin());
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size_ == 0;
+    }
+    size_t size() const noexcept {
+        return size_;
+    }
+    size_t capacity() const noexcept {
+        return capacity_;
+    }
+    //! Whether the elements are stored inline, i.e. the vector didn't allocate.
+    bool is_inline() const noexcept {
+        return data_ == InlineData();
+    }
+
+    T& operator[](size_t index) {
+        return data_[index];
+    }
+    const T& operator[](size_t index) const {
+        return data_[index];
+    }
+    T& at(size_t index) {
+        if (index >= size_) {
+            throw std::out_of_range("SmallVector::at");
+        }
+        return data_[index];
+    }
+    const T& at(size_t index) const {
+        if (index >= size_) {
+            throw std::out_of_range("SmallVector::at");
+        }
+        return data_[index];
+    }
+    T& front() {
+        return data_[0];
+    }
+    const T& front() const {
+        return data_[0];
+    }
+    T& back() {
+        return data_[size_ - 1];
+    }
+    const T& back() const {
+        return data_[size_ - 1];
+    }
+    T* data() noexcept {
+        return data_;
+    }
+    const T* data() const noexcept {
+        return data_;
+    }
+
+    void reserve(size_t capacity) {
+        if (capacity > capacity_) {
+            Grow(capacity);
+        }
+    }
+
+    void push_back(const T& value) {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value) {
+        emplace_back(std::move(value));
+    }
+
+    template <class... Args>
+    T& emplace_back(Args&&... args) {
+        if (size_ == capacity_) {
+            // The arguments may refer to an element, construct the new one before moving them.
+            T value(std::forward<Args>(args)...);
+            Grow(static_cast<size_t>(capacity_) * 2);
+            return *::new (static_cast<void*>(data_ + size_++)) T(std::move(value));
+        }
+        return *::new (static_cast<void*>(data_ + size_++)) T(std::forward<Args>(args)...);
+    }
+
+    void pop_back() {
+        data_[--size_].~T();
+    }
+
+    iterator erase(const_iterator position) {
+        return erase(position, position + 1);
+    }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        T* const begin_erase = data_ + (first - data_);
+        T* const end_erase = data_ + (last - data_);
+        if (begin_erase != end_erase) {
+            T* const new_end = std::move(end_erase, end(), begin_erase);
+            for (T* element = new_end; element != end(); ++element) {
+                element->~T();
+            }
+            size_ -= static_cast<uint32_t>(end_erase - begin_erase);
+        }
+        return begin_erase;
+    }
+
+    //! Destroys the elements, the allocated storage is kept for reuse.
+    void clear() noexcept {
+        for (size_t i = 0; i < size_; ++i) {
+            data_[i].~T();
+        }
+        size_ = 0;
+    }
+
+    void resize(size_t size) {
+        Resize(size, [](T* element) { ::new (static_cast<void*>(element)) T(); });
+    }
+
+    void resize(size_t size, const T& value) {
+        Resize(size, [&value](T* element) { ::new (static_cast<void*>(element)) T(value); });
+    }
+
+    void swap(SmallVector& other) {
+        SmallVector temporary(std::move(other));
+        other = std::move(*this);
+        *this = std::move(temporary);
+    }
+
+    friend bool operator==(const SmallVector& lhs, const SmallVector& rhs) {
+        return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+    }
+
+    friend bool operator!=(const SmallVector& lhs, const SmallVector& rhs) {
+        return !(lhs == rhs);
+    }
+
+private:
+    T* InlineData() noexcept {
+        return reinterpret_cast<T*>(inline_storage_);
+    }
+    const T* InlineData() const noexcept {
+        return reinterpret_cast<const T*>(inline_storage_);
+    }
+
+    template <class Construct>
+    void Resize(size_t size, Construct construct) {
+        if (size < size_) {
+            for (size_t i = size; i < size_; ++i) {
+                data_[i].~T();
+            }
+            size_ = static_cast<uint32_t>(size);
+            return;
+        }
+
+        reserve(size);
+        for (; size_ < size; ++size_) {
+            construct(data_ + size_);
+        }
+    }
+
+    void Grow(size_t capacity) {
+        T* const data = std::allocator<T>().allocate(capacity);
+        for (size_t i = 0; i < size_; ++i) {
+            ::new (static_cast<void*>(data + i)) T(std::move_if_noexcept(data_[i]));
+            data_[i].~T();
+        }
+
+        Deallocate();
+        data_ = data;
+        capacity_ = static_cast<uint32_t>(capacity);
+    }
+
+    void Deallocate() noexcept {
+        if (!is_inline()) {
+            std::allocator<T>().deallocate(data_, capacity_);
+            data_ = InlineData();
+            capacity_ = N;
+        }
+    }
+
+    // Takes the heap storage of the other vector or moves its inline elements, other is left empty. This vector must
+    // be empty.
+    void MoveFrom(SmallVector& other) {
+        if (!other.is_inline()) {
+            Deallocate();
+            data_ = other.data_;
+            size_ = other.size_;
+            capacity_ = other.capacity_;
+            other.data_ = other.InlineData();
+            other.size_ = 0;
+            other.capacity_ = N;
+            return;
+        }
+
+        reserve(other.size_);
+        for (size_t i = 0; i < other.size_; ++i) {
+            ::new (static_cast<void*>(data_ + i)) T(std::move(other.data_[i]));
+        }
+        size_ = other.size_;
+        other.clear();
+    }
+
+    T* data_;
+    uint32_t size_;
+    uint32_t capacity_;
+    alignas(T) unsigned char inline_storage_[N * sizeof(T)];
+};
+
+}  // namespace sc2
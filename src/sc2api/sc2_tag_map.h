@@ -0,0 +1,206 @@
+/*! \file sc2_tag_map.h
+    \brief A hash map from unit tags to small values.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "sc2_gametypes.h"
+
+namespace sc2 {
+
+//! An open addressing hash map keyed by unit tags, for values as small as a pointer. The entries are stored in one
+//! array and looked up by linear probing, a lookup usually reads a single cache line. NullTag marks the empty slots
+//! and can't be used as a key. Pointers to values are invalidated when the map grows.
+template <class T>
+class TagMap {
+    static_assert(std::is_trivially_copyable<T>::value, "TagMap holds small values like pointers or indices.");
+
+public:
+    //! Gets the value of a tag.
+    //!< \param tag The tag to look up.
+    //!< \return The value, nullptr if the tag isn't in the map.
+    T* Find(Tag tag) {
+        return const_cast<T*>(static_cast<const TagMap*>(this)->Find(tag));
+    }
+
+    const T* Find(Tag tag) const {
+        if (size_ == 0 || tag == NullTag) {
+            return nullptr;
+        }
+
+        const Entry& entry = entries_[FindIndex(tag)];
+        return entry.tag == tag ? &entry.value : nullptr;
+    }
+
+    bool Contains(Tag tag) const {
+        return Find(tag) != nullptr;
+    }
+
+    //! Adds a tag that isn't in the map yet.
+    //!< \param tag The tag, not NullTag.
+    //!< \param value The value of the tag.
+    //!< \return The value of the tag and whether it was added, an existing value is kept.
+    std::pair<T*, bool> Insert(Tag tag, const T& value) {
+        if (tag == NullTag) {
+            return std::make_pair(nullptr, false);
+        }
+
+        // Grow before the map is half full, probes stay short at that load.
+        if ((size_ + 1) * 2 > entries_.size()) {
+            Rehash(entries_.empty() ? kMinCapacity : entries_.size() * 2);
+        }
+
+        Entry& entry = entries_[FindIndex(tag)];
+        if (entry.tag == tag) {
+            return std::make_pair(&entry.value, false);
+        }
+
+        entry.tag = tag;
+        entry.value = value;
+        ++size_;
+        return std::make_pair(&entry.value, true);
+    }
+
+    //! Sets the value of a tag, adding the tag if needed.
+    T* InsertOrAssign(Tag tag, const T& value) {
+        std::pair<T*, bool> inserted = Insert(tag, value);
+        if (inserted.first) {
+            *inserted.first = value;
+        }
+        return inserted.first;
+    }
+
+    //! Removes a tag.
+    //!< \return Whether the tag was in the map.
+    bool Erase(Tag tag) {
+        if (size_ == 0 || tag == NullTag) {
+            return false;
+        }
+
+        size_t index = FindIndex(tag);
+        if (entries_[index].tag != tag) {
+            return false;
+        }
+
+        // Shifts the following entries of the probe sequence back instead of leaving a tombstone, entries only move
+        // if the emptied slot lies between their home slot and their slot.
+        const size_t mask = entries_.size() - 1;
+        for (size_t next = (index + 1) & mask; entries_[next].tag != NullTag; next = (next + 1) & mask) {
+            const size_t home = Hash(entries_[next].tag);
+            const bool home_after_hole =
+                index <= next ? (index < home && home <= next) : (index < home || home <= next);
+            if (!home_after_hole) {
+                entries_[index] = entries_[next];
+                index = next;
+            }
+        }
+
+        entries_[index].tag = NullTag;
+        --size_;
+        return true;
+    }
+
+    //! Removes all tags, the capacity is kept.
+    void Clear() {
+        if (size_ == 0) {
+            return;
+        }
+
+        for (Entry& entry : entries_) {
+            entry.tag = NullTag;
+        }
+        size_ = 0;
+    }
+
+    //! Makes room for the given number of tags without growing.
+    void Reserve(size_t count) {
+        size_t capacity = entries_.empty() ? kMinCapacity : entries_.size();
+        while (count * 2 > capacity) {
+            capacity *= 2;
+        }
+        if (capacity != entries_.size()) {
+            Rehash(capacity);
+        }
+    }
+
+    //! Calls the functor with the tag and the value of every entry, in no particular order.
+    template <typename Functor>
+    void ForEach(Functor&& functor) const {
+        for (const Entry& entry : entries_) {
+            if (entry.tag != NullTag) {
+                functor(entry.tag, entry.value);
+            }
+        }
+    }
+
+    size_t Size() const {
+        return size_;
+    }
+
+    bool Empty() const {
+        return size_ == 0;
+    }
+
+    //! The number of slots, the map holds at most half as many tags before growing.
+    size_t Capacity() const {
+        return entries_.size();
+    }
+
+    //! Bytes used by the slots.
+    size_t MemoryUsage() const {
+        return entries_.capacity() * sizeof(Entry);
+    }
+
+private:
+    struct Entry {
+        Tag tag;
+        T value;
+    };
+
+    static const size_t kMinCapacity = 16;
+
+    // Fibonacci hashing, the top bits of the product depend on every bit of the tag. Live units differ mostly in the
+    // low bits of their tags, which hold the unit index, the high bits count how often an index was reused.
+    size_t Hash(Tag tag) const {
+        return static_cast<size_t>((tag * 0x9E3779B97F4A7C15ULL) >> shift_);
+    }
+
+    // The slot holding the tag or the empty slot where its probe sequence ends.
+    size_t FindIndex(Tag tag) const {
+        const size_t mask = entries_.size() - 1;
+        size_t index = Hash(tag);
+        while (entries_[index].tag != tag && entries_[index].tag != NullTag) {
+            index = (index + 1) & mask;
+        }
+        return index;
+    }
+
+    void Rehash(size_t capacity) {
+        std::vector<Entry> entries(capacity, Entry{NullTag, T()});
+        entries_.swap(entries);
+
+        shift_ = 64;
+        for (size_t slots = capacity; slots > 1; slots /= 2) {
+            --shift_;
+        }
+
+        for (const Entry& entry : entries) {
+            if (entry.tag != NullTag) {
+                entries_[FindIndex(entry.tag)] = entry;
+            }
+        }
+    }
+
+    std::vector<Entry> entries_;
+    size_t size_ = 0;
+    // 64 - log2 of the capacity.
+    int shift_ = 64;
+};
+
+}  // namespace sc2
@@ -1,5 +1,6 @@
 #include "sc2_unit.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
@@ -11,6 +12,10 @@ bool Unit::IsBuildFinished() const {
     return build_progress >= 1.0F;
 }
 
+bool Unit::HasChanged(uint32_t fields) const {
+    return (changed_fields & fields) != 0;
+}
+
 Tags ConvertToTags(const Units& units) {
     Tags tags;
     std::transform(std::begin(units), std::end(units), std::back_inserter(tags),
@@ -22,32 +27,54 @@ Tags ConvertToTags(const Units& units) {
 Unit* UnitPool::CreateUnit(Tag tag) {
     Unit* existing = GetUnit(tag);
     if (existing) {
-        tag_to_existing_unit_[tag] = existing;
+        if (tag_to_existing_unit_.Insert(tag, existing).second) {
+            existing_units_.push_back(existing);
+        }
         return existing;
     }
 
-    if (unit_pool_.empty() || unit_pool_.size() == available_index_.first) {
-        unit_pool_.push_back(std::vector<Unit>(ENTRY_SIZE));
-    }
-
-    std::vector<Unit>& pool = unit_pool_[available_index_.first];
-    Unit* unit = &pool[available_index_.second];
+    Unit* unit = AllocateSlot();
     unit->last_seen_game_loop = 0;  // initialization required for OnUnitEnterVision
-    tag_to_unit_[tag] = unit;
-    tag_to_existing_unit_[tag] = unit;
+    unit->changed_fields = Unit::ChangedAll;
+    tag_to_unit_.InsertOrAssign(tag, unit);
+    tag_to_existing_unit_.InsertOrAssign(tag, unit);
+    existing_units_.push_back(unit);
     AddNewUnit(unit);
-    IncrementIndex();
+    return unit;
+}
+
+Unit* UnitPool::AllocateSlot() {
+    // The index of a slot is its position in the pool, a reused slot keeps it.
+    Unit* unit = nullptr;
+    uint32_t index = 0;
+    if (!free_units_.empty()) {
+        unit = free_units_.back();
+        index = unit->index;
+        free_units_.pop_back();
+    } else {
+        if (unit_pool_.size() == available_index_.first) {
+            unit_pool_.push_back(std::vector<Unit>(ENTRY_SIZE));
+        }
+
+        // Slots below the index held units of a previous game if the pool was reset.
+        unit = &unit_pool_[available_index_.first][available_index_.second];
+        index = MaxIndex();
+        IncrementIndex();
+    }
+
+    *unit = Unit();
+    unit->index = index;
     return unit;
 }
 
 Unit* UnitPool::GetUnit(Tag tag) const {
-    auto found = tag_to_unit_.find(tag);
-    return found == tag_to_unit_.end() ? nullptr : found->second;
+    Unit* const* found = tag_to_unit_.Find(tag);
+    return found ? *found : nullptr;
 }
 
 Unit* UnitPool::GetExistingUnit(Tag tag) const {
-    auto found = tag_to_existing_unit_.find(tag);
-    return found == tag_to_existing_unit_.end() ? nullptr : found->second;
+    Unit* const* found = tag_to_existing_unit_.Find(tag);
+    return found ? *found : nullptr;
 }
 
 void UnitPool::IncrementIndex() {
@@ -63,29 +90,200 @@ void UnitPool::MarkDead(Tag tag) {
     if (!unit) {
         return;
     }
+    if (unit->is_alive && dead_unit_retention_ != kKeepDeadUnits) {
+        dead_units_.push_back(unit);
+    }
     unit->is_alive = false;
     // CHeck if this is necessary, bro
-    tag_to_existing_unit_.erase(tag);
+    if (tag_to_existing_unit_.Erase(tag)) {
+        // Removed from the lists of existing units by RemoveDeadExistingUnits, once for all units that died.
+        has_dead_existing_units_ = true;
+    }
+}
+
+void UnitPool::RemoveDeadExistingUnits() {
+    if (!has_dead_existing_units_) {
+        return;
+    }
+    has_dead_existing_units_ = false;
+
+    // Units of the observation are alive unless they were marked dead since.
+    auto is_dead = [](const Unit* unit) { return !unit->is_alive; };
+    for (Unit* unit : existing_units_) {
+        if (!unit->is_alive) {
+            unit->changed_fields = Unit::ChangedNone;
+        }
+    }
+    existing_units_.erase(std::remove_if(existing_units_.begin(), existing_units_.end(), is_dead),
+                          existing_units_.end());
+    units_changed_.erase(std::remove_if(units_changed_.begin(), units_changed_.end(), is_dead), units_changed_.end());
+
+    for (size_t idx = 0; idx < existing_units_by_alliance_.size(); ++idx) {
+        Units& units = existing_units_by_alliance_[idx];
+        units.erase(std::remove_if(units.begin(), units.end(), is_dead), units.end());
+
+        std::vector<Units>& units_by_type = existing_units_by_type_[idx];
+        std::vector<UnitTypeID>& types = existing_unit_types_[idx];
+        auto remove_type = [&units_by_type, &is_dead](UnitTypeID type) {
+            Units& units_of_type = units_by_type[static_cast<size_t>(type)];
+            units_of_type.erase(std::remove_if(units_of_type.begin(), units_of_type.end(), is_dead),
+                                units_of_type.end());
+            return units_of_type.empty();
+        };
+        types.erase(std::remove_if(types.begin(), types.end(), remove_type), types.end());
+    }
+}
+
+const Units& UnitPool::GetExistingUnits(Unit::Alliance alliance) const {
+    static const Units empty;
+
+    const size_t idx = static_cast<size_t>(alliance) - Unit::Alliance::Self;
+    if (idx >= existing_units_by_alliance_.size()) {
+        return empty;
+    }
+
+    return existing_units_by_alliance_[idx];
+}
+
+const Units& UnitPool::GetExistingUnits(Unit::Alliance alliance, UnitTypeID type) const {
+    static const Units empty;
+
+    const size_t idx = static_cast<size_t>(alliance) - Unit::Alliance::Self;
+    if (idx >= existing_units_by_type_.size() || static_cast<size_t>(type) >= existing_units_by_type_[idx].size()) {
+        return empty;
+    }
+
+    return existing_units_by_type_[idx][static_cast<size_t>(type)];
 }
 
-void UnitPool::ForEachExistingUnit(const std::function<void(Unit& unit)>& functor) const {
-    for (const auto& u : tag_to_existing_unit_) {
-        assert(u.second);
-        functor(*u.second);
+const std::vector<UnitTypeID>& UnitPool::GetExistingUnitTypes(Unit::Alliance alliance) const {
+    static const std::vector<UnitTypeID> empty;
+
+    const size_t idx = static_cast<size_t>(alliance) - Unit::Alliance::Self;
+    if (idx >= existing_unit_types_.size()) {
+        return empty;
+    }
+
+    return existing_unit_types_[idx];
+}
+
+void UnitPool::IndexExistingUnits() {
+    ClearUnitIndices();
+
+    for (const Unit* unit : existing_units_) {
+        const size_t idx = static_cast<size_t>(unit->alliance) - Unit::Alliance::Self;
+        if (idx >= existing_units_by_alliance_.size()) {
+            continue;
+        }
+
+        existing_units_by_alliance_[idx].push_back(unit);
+
+        std::vector<Units>& units_by_type = existing_units_by_type_[idx];
+        const size_t type = static_cast<size_t>(unit->unit_type);
+        if (type >= units_by_type.size()) {
+            units_by_type.resize(type + 1);
+        }
+        if (units_by_type[type].empty()) {
+            existing_unit_types_[idx].push_back(unit->unit_type);
+        }
+        units_by_type[type].push_back(unit);
+    }
+}
+
+void UnitPool::ClearUnitIndices() {
+    for (size_t idx = 0; idx < existing_units_by_alliance_.size(); ++idx) {
+        existing_units_by_alliance_[idx].clear();
+        for (UnitTypeID type : existing_unit_types_[idx]) {
+            existing_units_by_type_[idx][static_cast<size_t>(type)].clear();
+        }
+        existing_unit_types_[idx].clear();
     }
 }
 
 void UnitPool::ClearExisting() {
-    tag_to_existing_unit_.clear();
+    // Units that are seen again get their changes since this observation, the others have none.
+    for (Unit* unit : existing_units_) {
+        unit->changed_fields = Unit::ChangedNone;
+    }
+
+    tag_to_existing_unit_.Clear();
+    existing_units_.clear();
+    has_dead_existing_units_ = false;
+    ClearUnitIndices();
     units_newly_created_.clear();
     units_entering_vision_.clear();
     buildings_constructed_.clear();
     units_idled_.clear();
     units_damaged_.clear();
+    units_changed_.clear();
+}
+
+void UnitPool::SetDeadUnitRetention(uint32_t game_loops) {
+    // Dead units aren't tracked while they are kept for good, collect the ones that died meanwhile.
+    if (dead_unit_retention_ == kKeepDeadUnits && game_loops != kKeepDeadUnits) {
+        dead_units_.clear();
+        tag_to_unit_.ForEach([this](Tag, Unit* unit) {
+            if (!unit->is_alive) {
+                dead_units_.push_back(unit);
+            }
+        });
+    } else if (game_loops == kKeepDeadUnits) {
+        dead_units_.clear();
+    }
+
+    dead_unit_retention_ = game_loops;
+}
+
+void UnitPool::ReclaimDeadUnits(uint32_t game_loop) {
+    if (dead_unit_retention_ == kKeepDeadUnits) {
+        return;
+    }
+
+    auto reclaim = [this, game_loop](Unit* unit) {
+        // Units reported again after their death are alive.
+        if (unit->is_alive) {
+            return true;
+        }
+        if (game_loop - unit->last_seen_game_loop <= dead_unit_retention_) {
+            return false;
+        }
+
+        Unit* const* found = tag_to_unit_.Find(unit->tag);
+        if (found && *found == unit) {
+            tag_to_unit_.Erase(unit->tag);
+            free_units_.push_back(unit);
+        }
+        return true;
+    };
+    dead_units_.erase(std::remove_if(dead_units_.begin(), dead_units_.end(), reclaim), dead_units_.end());
+}
+
+void UnitPool::Reset() {
+    ClearExisting();
+    tag_to_unit_.Clear();
+    free_units_.clear();
+    dead_units_.clear();
+    available_index_ = std::make_pair(0, 0);
+}
+
+UnitPoolReport UnitPool::GetReport() const {
+    UnitPoolReport report;
+    report.slots = unit_pool_.size() * ENTRY_SIZE;
+    report.units = tag_to_unit_.Size();
+    report.existing_units = existing_units_.size();
+    report.dead_units = dead_units_.size();
+    if (dead_unit_retention_ == kKeepDeadUnits) {
+        tag_to_unit_.ForEach([&report](Tag, const Unit* unit) { report.dead_units += unit->is_alive ? 0 : 1; });
+    }
+    report.free_slots = free_units_.size();
+
+    report.bytes = report.slots * sizeof(Unit) + tag_to_unit_.MemoryUsage() + tag_to_existing_unit_.MemoryUsage() +
+                   (free_units_.capacity() + dead_units_.capacity() + existing_units_.capacity()) * sizeof(Unit*);
+    return report;
 }
 
 bool UnitPool::UnitExists(Tag tag) {
-    return tag_to_existing_unit_.find(tag) != tag_to_existing_unit_.end();
+    return tag_to_existing_unit_.Contains(tag);
 }
 
 }  // namespace sc2
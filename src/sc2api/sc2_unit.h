@@ -5,6 +5,7 @@
 
 #include <stdint.h>
 
+#include <array>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -13,6 +14,8 @@
 #include "sc2_common.h"
 #include "sc2_gametypes.h"
 #include "sc2_proto_interface.h"
+#include "sc2_small_vector.h"
+#include "sc2_tag_map.h"
 #include "sc2_typeenums.h"
 
 namespace sc2 {
@@ -93,6 +96,30 @@ public:
         CloakedAllied = 4,
     };
 
+    //! Fields of which changes since the previous observation are tracked, see changed_fields.
+    enum ChangedField : uint32_t {
+        //! Nothing changed.
+        ChangedNone = 0,
+        //! The position.
+        ChangedPosition = 1 << 0,
+        //! The health or max health.
+        ChangedHealth = 1 << 1,
+        //! The shield or max shield.
+        ChangedShield = 1 << 2,
+        //! The energy or max energy.
+        ChangedEnergy = 1 << 3,
+        //! The orders, their ability or target. The progress of the orders is not tracked.
+        ChangedOrders = 1 << 4,
+        //! The buffs.
+        ChangedBuffs = 1 << 5,
+        //! The display type.
+        ChangedDisplayType = 1 << 6,
+        //! The build progress.
+        ChangedBuildProgress = 1 << 7,
+        //! All fields, set for units seen for the first time.
+        ChangedAll = (1 << 8) - 1,
+    };
+
     //! If the unit is shown on screen or not.
     DisplayType display_type;
     //! Relationship of the unit to this player.
@@ -100,6 +127,11 @@ public:
 
     //! A unique identifier for the instance of a unit.
     Tag tag;
+    //! A dense index of the unit within the game, below UnitPool::MaxIndex() and
+    //! ObservationInterface::GetMaxUnitIndex(). Stays the same for the life of the unit and is only given to another
+    //! unit once the dead unit is reclaimed, see ControlInterface::SetDeadUnitRetention. Meant for keeping data of
+    //! units in arrays and bitsets instead of maps keyed by tag.
+    uint32_t index;
     //! An identifier of the type of unit.
     UnitTypeID unit_type;
     //! Which player owns a unit.
@@ -159,11 +191,11 @@ public:
     // Not populated for enemies/snapshots
 
     //! Orders on a unit. Only valid for this player's units.
-    std::vector<UnitOrder> orders;
+    SmallVector<UnitOrder, 4> orders;
     //! Add-on like a tech lab or reactor. Only valid for this player's units.
     Tag add_on_tag;
     //! Passengers in this transport. Only valid for this player's units.
-    std::vector<PassengerUnit> passengers;
+    SmallVector<PassengerUnit, 8> passengers;
     //! Number of cargo slots used in the transport. Only valid for this player's units.
     int cargo_space_taken;
     //! Number of cargo slots available for a transport. Only valid for this player's units.
@@ -176,7 +208,7 @@ public:
     //! Target unit of a unit. Only valid for this player's units.
     Tag engaged_target_tag;
     //! Buffs on this unit. Only valid for this player's units.
-    std::vector<BuffID> buffs;
+    SmallVector<BuffID, 4> buffs;
     //! Whether the unit is powered by a pylon.
     bool is_powered;
 
@@ -197,8 +229,15 @@ public:
     //! Whether the unit is building or not.
     bool is_building;
 
+    //! Fields that changed since the previous observation, a mask of ChangedField.
+    uint32_t changed_fields;
+
     //! Whether the unit construction/training completed.
     [[nodiscard]] bool IsBuildFinished() const;
+
+    //! Whether any of the given fields changed since the previous observation.
+    //!< \param fields A mask of ChangedField.
+    [[nodiscard]] bool HasChanged(uint32_t fields) const;
 };
 
 using Units = std::vector<const Unit*>;
@@ -215,15 +254,74 @@ struct UnitDamage {
 
 using UnitsDamaged = std::vector<UnitDamage>;
 
+//! Memory held by the units of a client, to watch it over long games or many replays.
+struct UnitPoolReport {
+    //! Unit slots allocated, the pool grows by a thousand slots at a time.
+    size_t slots = 0;
+    //! Units held in slots, including dead and out of sight units.
+    size_t units = 0;
+    //! Units of the current observation.
+    size_t existing_units = 0;
+    //! Dead units kept until their retention ends.
+    size_t dead_units = 0;
+    //! Slots freed from dead units, reused before the pool grows.
+    size_t free_slots = 0;
+    //! Approximate bytes used by the slots and the tag maps. Lists of units that outgrew their inline storage aren't
+    //! counted.
+    size_t bytes = 0;
+};
+
 class UnitPool {
 public:
+    //! Retention that keeps dead units for the rest of the game.
+    static constexpr uint32_t kKeepDeadUnits = UINT32_MAX;
+
     Unit* CreateUnit(Tag tag);
     [[nodiscard]] Unit* GetUnit(Tag tag) const;
     [[nodiscard]] Unit* GetExistingUnit(Tag tag) const;
+    //! Marks a unit dead and removes it from the existing units. The lists of existing units keep it until
+    //! RemoveDeadExistingUnits is called, so that the units dying in a step are removed in one pass.
     void MarkDead(Tag tag);
+    //! Removes the units marked dead from the lists of existing units, changed units and the groups by alliance and
+    //! type.
+    void RemoveDeadExistingUnits();
+
+    //! Sets how many game loops dead units are kept after they were last seen, kKeepDeadUnits by default.
+    void SetDeadUnitRetention(uint32_t game_loops);
+    [[nodiscard]] uint32_t GetDeadUnitRetention() const noexcept {
+        return dead_unit_retention_;
+    }
+    //! Frees the slots of the dead units whose retention ended, pointers to them are invalid afterwards. Called before
+    //! converting an observation, so that a unit stays valid for the events of the step it died in.
+    void ReclaimDeadUnits(uint32_t game_loop);
+    //! Forgets all units, e.g. between games. The slots are kept for the units of the next game.
+    void Reset();
+    [[nodiscard]] UnitPoolReport GetReport() const;
+    //! One past the highest Unit::index given out this game, the size of arrays indexed by unit.
+    [[nodiscard]] uint32_t MaxIndex() const noexcept {
+        return static_cast<uint32_t>(available_index_.first * ENTRY_SIZE + available_index_.second);
+    }
 
     // TODO(?): Change alive -> Exist
-    void ForEachExistingUnit(const std::function<void(Unit& unit)>& functor) const;
+    //! Calls the functor for each unit of the current observation, in the order the units were observed.
+    template <typename Functor>
+    void ForEachExistingUnit(Functor&& functor) const {
+        for (Unit* unit : existing_units_) {
+            functor(*unit);
+        }
+    }
+    [[nodiscard]] const std::vector<Unit*>& GetExistingUnits() const noexcept {
+        return existing_units_;
+    }
+    //! Existing units of the given alliance, valid after IndexExistingUnits was called for the current observation.
+    [[nodiscard]] const Units& GetExistingUnits(Unit::Alliance alliance) const;
+    //! Existing units of the given alliance and type, valid after IndexExistingUnits was called for the current
+    //! observation.
+    [[nodiscard]] const Units& GetExistingUnits(Unit::Alliance alliance, UnitTypeID type) const;
+    //! Types of the existing units of the given alliance, in the order they were first observed.
+    [[nodiscard]] const std::vector<UnitTypeID>& GetExistingUnitTypes(Unit::Alliance alliance) const;
+    //! Groups the existing units by alliance and type. Called once all units of an observation have been converted.
+    void IndexExistingUnits();
     void ClearExisting();
     bool UnitExists(Tag tag);
 
@@ -242,6 +340,10 @@ public:
     [[nodiscard]] const std::unordered_set<const Unit*>& GetIdledUnits() const noexcept {
         return units_idled_;
     };
+    //! Existing units with any field in Unit::ChangedField changed since the previous observation.
+    [[nodiscard]] const Units& GetChangedUnits() const noexcept {
+        return units_changed_;
+    };
 
     void AddNewUnit(const Unit* u) {
         units_newly_created_.push_back(u);
@@ -260,21 +362,45 @@ public:
     void AddUnitDamaged(const Unit* u, float health, float shield) {
         units_damaged_.push_back({u, health, shield});
     }
+    void AddUnitChanged(const Unit* u) {
+        units_changed_.push_back(u);
+    }
 
 private:
     void IncrementIndex();
 
+    // The slot of a new unit, a freed one if any.
+    Unit* AllocateSlot();
+    // Empties the lists of existing units by alliance and type.
+    void ClearUnitIndices();
+
     static const size_t ENTRY_SIZE = 1000;
     // std::array<Unit, ENTRY_SIZE>
     std::vector<std::vector<Unit> > unit_pool_;
     std::pair<size_t, size_t> available_index_;
-    std::unordered_map<Tag, Unit*> tag_to_unit_;
-    std::unordered_map<Tag, Unit*> tag_to_existing_unit_;
+    // Slots of reclaimed units, reused before the next unused slot.
+    std::vector<Unit*> free_units_;
+    // Dead units waiting for their retention to end, only tracked while the retention is limited.
+    std::vector<Unit*> dead_units_;
+    uint32_t dead_unit_retention_ = kKeepDeadUnits;
+    TagMap<Unit*> tag_to_unit_;
+    TagMap<Unit*> tag_to_existing_unit_;
+    // Dense copy of tag_to_existing_unit_ values, iterated instead of the map.
+    std::vector<Unit*> existing_units_;
+    // Whether units were marked dead since the lists of existing units were last compacted.
+    bool has_dead_existing_units_ = false;
+    // Existing units grouped by alliance, indexed by Unit::Alliance - Unit::Self.
+    std::array<Units, 4> existing_units_by_alliance_;
+    // Existing units grouped by alliance as above and then by unit type, indexed by the type id.
+    std::array<std::vector<Units>, 4> existing_units_by_type_;
+    // Types with existing units for every alliance, only their lists are visited and cleared.
+    std::array<std::vector<UnitTypeID>, 4> existing_unit_types_;
     Units units_newly_created_;
     Units units_entering_vision_;
     Units buildings_constructed_;
     UnitsDamaged units_damaged_;
     std::unordered_set<const Unit*> units_idled_;
+    Units units_changed_;
 };
 
 }  // namespace sc2
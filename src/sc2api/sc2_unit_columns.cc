@@ -0,0 +1,317 @@
+#include "sc2_unit_columns.h"
+
+#include <limits>
+
+#include "sc2_simd.h"
+
+namespace sc2 {
+
+namespace {
+
+// Matches the units of any alliance in the kernels below.
+const int32_t kAnyAlliance = 0;
+
+// The kernels process the columns a vector at a time with the instruction set given by GetSimdLevel. All of them
+// compute the squared distances the same way as DistanceSquared2D so that they return the same units.
+
+void CollectInRangeScalar(const UnitColumns& columns, const Point2D& center, float radius_squared, int32_t alliance,
+                          Units& units) {
+    const size_t size = columns.Size();
+    for (size_t row = 0; row < size; ++row) {
+        if (alliance != kAnyAlliance && columns.alliance[row] != alliance) {
+            continue;
+        }
+
+        const float dx = center.x - columns.x[row];
+        const float dy = center.y - columns.y[row];
+        if (dx * dx + dy * dy <= radius_squared) {
+            units.push_back(columns.units[row]);
+        }
+    }
+}
+
+const Unit* FindNearestScalar(const UnitColumns& columns, const Point2D& point, int32_t alliance) {
+    const Unit* nearest = nullptr;
+    float nearest_distance = std::numeric_limits<float>::infinity();
+    const size_t size = columns.Size();
+    for (size_t row = 0; row < size; ++row) {
+        if (alliance != kAnyAlliance && columns.alliance[row] != alliance) {
+            continue;
+        }
+
+        const float dx = point.x - columns.x[row];
+        const float dy = point.y - columns.y[row];
+        const float distance = dx * dx + dy * dy;
+        if (distance < nearest_distance) {
+            nearest_distance = distance;
+            nearest = columns.units[row];
+        }
+    }
+
+    return nearest;
+}
+
+#if defined(SC2_SIMD_X86)
+
+SC2_TARGET_AVX2 void CollectInRangeAvx2(const UnitColumns& columns, const Point2D& center, float radius_squared,
+                                        int32_t alliance, Units& units) {
+    const __m256 center_x = _mm256_set1_ps(center.x);
+    const __m256 center_y = _mm256_set1_ps(center.y);
+    const __m256 range = _mm256_set1_ps(radius_squared);
+    const __m256i wanted_alliance = _mm256_set1_epi32(alliance);
+
+    const size_t rows = columns.x.size();
+    for (size_t row = 0; row < rows; row += 8) {
+        const __m256 dx = _mm256_sub_ps(center_x, _mm256_load_ps(&columns.x[row]));
+        const __m256 dy = _mm256_sub_ps(center_y, _mm256_load_ps(&columns.y[row]));
+        const __m256 distance = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        __m256 in_range = _mm256_cmp_ps(distance, range, _CMP_LE_OQ);
+        if (alliance != kAnyAlliance) {
+            const __m256i row_alliance =
+                _mm256_load_si256(reinterpret_cast<const __m256i*>(&columns.alliance[row]));
+            in_range = _mm256_and_ps(in_range, _mm256_castsi256_ps(_mm256_cmpeq_epi32(row_alliance, wanted_alliance)));
+        }
+
+        for (int mask = _mm256_movemask_ps(in_range), lane = 0; mask; mask >>= 1, ++lane) {
+            if (mask & 1) {
+                units.push_back(columns.units[row + lane]);
+            }
+        }
+    }
+}
+
+SC2_TARGET_AVX2 const Unit* FindNearestAvx2(const UnitColumns& columns, const Point2D& point, int32_t alliance) {
+    const __m256 point_x = _mm256_set1_ps(point.x);
+    const __m256 point_y = _mm256_set1_ps(point.y);
+    const __m256i wanted_alliance = _mm256_set1_epi32(alliance);
+    const __m256i step = _mm256_set1_epi32(8);
+
+    // Every lane keeps the first closest row it has seen.
+    __m256 best_distance = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+    __m256i best_row = _mm256_set1_epi32(-1);
+    __m256i row_index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    const size_t rows = columns.x.size();
+    for (size_t row = 0; row < rows; row += 8) {
+        const __m256 dx = _mm256_sub_ps(point_x, _mm256_load_ps(&columns.x[row]));
+        const __m256 dy = _mm256_sub_ps(point_y, _mm256_load_ps(&columns.y[row]));
+        const __m256 distance = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        __m256 closer = _mm256_cmp_ps(distance, best_distance, _CMP_LT_OQ);
+        if (alliance != kAnyAlliance) {
+            const __m256i row_alliance =
+                _mm256_load_si256(reinterpret_cast<const __m256i*>(&columns.alliance[row]));
+            closer = _mm256_and_ps(closer, _mm256_castsi256_ps(_mm256_cmpeq_epi32(row_alliance, wanted_alliance)));
+        }
+
+        best_distance = _mm256_blendv_ps(best_distance, distance, closer);
+        best_row = _mm256_blendv_epi8(best_row, row_index, _mm256_castps_si256(closer));
+        row_index = _mm256_add_epi32(row_index, step);
+    }
+
+    alignas(32) float distances[8];
+    alignas(32) int32_t best_rows[8];
+    _mm256_store_ps(distances, best_distance);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(best_rows), best_row);
+
+    // Of equally distant units the one of the first row wins, as with a scan in order.
+    int32_t nearest = -1;
+    for (int lane = 0; lane < 8; ++lane) {
+        if (best_rows[lane] < 0) {
+            continue;
+        }
+        if (nearest < 0 || distances[lane] < distances[nearest % 8] ||
+            (distances[lane] == distances[nearest % 8] && best_rows[lane] < nearest)) {
+            nearest = best_rows[lane];
+        }
+    }
+
+    return nearest < 0 ? nullptr : columns.units[nearest];
+}
+
+__m128 Select(__m128 mask, __m128 if_true, __m128 if_false) {
+    return _mm_or_ps(_mm_and_ps(mask, if_true), _mm_andnot_ps(mask, if_false));
+}
+
+__m128i Select(__m128i mask, __m128i if_true, __m128i if_false) {
+    return _mm_or_si128(_mm_and_si128(mask, if_true), _mm_andnot_si128(mask, if_false));
+}
+
+void CollectInRangeSse2(const UnitColumns& columns, const Point2D& center, float radius_squared, int32_t alliance,
+                        Units& units) {
+    const __m128 center_x = _mm_set1_ps(center.x);
+    const __m128 center_y = _mm_set1_ps(center.y);
+    const __m128 range = _mm_set1_ps(radius_squared);
+    const __m128i wanted_alliance = _mm_set1_epi32(alliance);
+
+    const size_t rows = columns.x.size();
+    for (size_t row = 0; row < rows; row += 4) {
+        const __m128 dx = _mm_sub_ps(center_x, _mm_load_ps(&columns.x[row]));
+        const __m128 dy = _mm_sub_ps(center_y, _mm_load_ps(&columns.y[row]));
+        const __m128 distance = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128 in_range = _mm_cmple_ps(distance, range);
+        if (alliance != kAnyAlliance) {
+            const __m128i row_alliance = _mm_load_si128(reinterpret_cast<const __m128i*>(&columns.alliance[row]));
+            in_range = _mm_and_ps(in_range, _mm_castsi128_ps(_mm_cmpeq_epi32(row_alliance, wanted_alliance)));
+        }
+
+        for (int mask = _mm_movemask_ps(in_range), lane = 0; mask; mask >>= 1, ++lane) {
+            if (mask & 1) {
+                units.push_back(columns.units[row + lane]);
+            }
+        }
+    }
+}
+
+const Unit* FindNearestSse2(const UnitColumns& columns, const Point2D& point, int32_t alliance) {
+    const __m128 point_x = _mm_set1_ps(point.x);
+    const __m128 point_y = _mm_set1_ps(point.y);
+    const __m128i wanted_alliance = _mm_set1_epi32(alliance);
+    const __m128i step = _mm_set1_epi32(4);
+
+    // Every lane keeps the first closest row it has seen.
+    __m128 best_distance = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    __m128i best_row = _mm_set1_epi32(-1);
+    __m128i row_index = _mm_setr_epi32(0, 1, 2, 3);
+
+    const size_t rows = columns.x.size();
+    for (size_t row = 0; row < rows; row += 4) {
+        const __m128 dx = _mm_sub_ps(point_x, _mm_load_ps(&columns.x[row]));
+        const __m128 dy = _mm_sub_ps(point_y, _mm_load_ps(&columns.y[row]));
+        const __m128 distance = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128 closer = _mm_cmplt_ps(distance, best_distance);
+        if (alliance != kAnyAlliance) {
+            const __m128i row_alliance = _mm_load_si128(reinterpret_cast<const __m128i*>(&columns.alliance[row]));
+            closer = _mm_and_ps(closer, _mm_castsi128_ps(_mm_cmpeq_epi32(row_alliance, wanted_alliance)));
+        }
+
+        best_distance = Select(closer, distance, best_distance);
+        best_row = Select(_mm_castps_si128(closer), row_index, best_row);
+        row_index = _mm_add_epi32(row_index, step);
+    }
+
+    alignas(16) float distances[4];
+    alignas(16) int32_t best_rows[4];
+    _mm_store_ps(distances, best_distance);
+    _mm_store_si128(reinterpret_cast<__m128i*>(best_rows), best_row);
+
+    // Of equally distant units the one of the first row wins, as with a scan in order.
+    int32_t nearest = -1;
+    for (int lane = 0; lane < 4; ++lane) {
+        if (best_rows[lane] < 0) {
+            continue;
+        }
+        if (nearest < 0 || distances[lane] < distances[nearest % 4] ||
+            (distances[lane] == distances[nearest % 4] && best_rows[lane] < nearest)) {
+            nearest = best_rows[lane];
+        }
+    }
+
+    return nearest < 0 ? nullptr : columns.units[nearest];
+}
+
+#endif
+
+void CollectInRange(const UnitColumns& columns, const Point2D& center, float radius_squared, int32_t alliance,
+                    Units& units) {
+#if defined(SC2_SIMD_X86)
+    switch (GetSimdLevel()) {
+        case SimdLevel::AVX2:
+            CollectInRangeAvx2(columns, center, radius_squared, alliance, units);
+            return;
+        case SimdLevel::SSE2:
+            CollectInRangeSse2(columns, center, radius_squared, alliance, units);
+            return;
+        default:
+            break;
+    }
+#endif
+    CollectInRangeScalar(columns, center, radius_squared, alliance, units);
+}
+
+const Unit* FindNearest(const UnitColumns& columns, const Point2D& point, int32_t alliance) {
+#if defined(SC2_SIMD_X86)
+    switch (GetSimdLevel()) {
+        case SimdLevel::AVX2:
+            return FindNearestAvx2(columns, point, alliance);
+        case SimdLevel::SSE2:
+            return FindNearestSse2(columns, point, alliance);
+        default:
+            break;
+    }
+#endif
+    return FindNearestScalar(columns, point, alliance);
+}
+
+}  // namespace
+
+void UnitColumns::Assign(const Units& new_units) {
+    units = new_units;
+
+    const size_t size = units.size();
+    const size_t rows = (size + kLanes - 1) / kLanes * kLanes;
+    tag.resize(rows);
+    unit_type.resize(rows);
+    alliance.resize(rows);
+    x.resize(rows);
+    y.resize(rows);
+    z.resize(rows);
+    radius.resize(rows);
+    health.resize(rows);
+    shield.resize(rows);
+    energy.resize(rows);
+    weapon_cooldown.resize(rows);
+
+    for (size_t row = 0; row < size; ++row) {
+        const Unit& unit = *units[row];
+        tag[row] = unit.tag;
+        unit_type[row] = unit.unit_type;
+        alliance[row] = static_cast<int32_t>(unit.alliance);
+        x[row] = unit.pos.x;
+        y[row] = unit.pos.y;
+        z[row] = unit.pos.z;
+        radius[row] = unit.radius;
+        health[row] = unit.health;
+        shield[row] = unit.shield;
+        energy[row] = unit.energy;
+        weapon_cooldown[row] = unit.weapon_cooldown;
+    }
+
+    // NaN coordinates are never in range nor closer than anything.
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    for (size_t row = size; row < rows; ++row) {
+        tag[row] = NullTag;
+        unit_type[row] = 0;
+        alliance[row] = kAnyAlliance;
+        x[row] = nan;
+        y[row] = nan;
+        z[row] = nan;
+        radius[row] = 0.0F;
+        health[row] = 0.0F;
+        shield[row] = 0.0F;
+        energy[row] = 0.0F;
+        weapon_cooldown[row] = 0.0F;
+    }
+}
+
+void UnitColumns::Clear() {
+    Assign(Units());
+}
+
+void UnitColumns::GetUnitsInRange(const Point2D& center, float radius, Units& result) const {
+    CollectInRange(*this, center, radius * radius, kAnyAlliance, result);
+}
+
+void UnitColumns::GetUnitsInRange(const Point2D& center, float radius, Unit::Alliance unit_alliance,
+                                  Units& result) const {
+    CollectInRange(*this, center, radius * radius, static_cast<int32_t>(unit_alliance), result);
+}
+
+const Unit* UnitColumns::GetNearestUnit(const Point2D& point) const {
+    return FindNearest(*this, point, kAnyAlliance);
+}
+
+const Unit* UnitColumns::GetNearestUnit(const Point2D& point, Unit::Alliance unit_alliance) const {
+    return FindNearest(*this, point, static_cast<int32_t>(unit_alliance));
+}
+
+}  // namespace sc2
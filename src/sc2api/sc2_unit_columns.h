@@ -0,0 +1,124 @@
+/*! \file sc2_unit_columns.h
+    \brief Structure of arrays copy of the units of an observation, for vectorized queries.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <new>
+#include <vector>
+
+#include "sc2_common.h"
+#include "sc2_unit.h"
+
+namespace sc2 {
+
+//! Allocator of memory aligned for the widest vector registers the columns are processed with.
+template <class T>
+struct ColumnAllocator {
+    using value_type = T;
+
+    //! Alignment of the columns in bytes, the width of an AVX register.
+    static constexpr size_t kAlignment = 32;
+
+    ColumnAllocator() = default;
+    template <class U>
+    ColumnAllocator(const ColumnAllocator<U>&) noexcept {
+    }
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(kAlignment)));
+    }
+
+    void deallocate(T* pointer, size_t) noexcept {
+        ::operator delete(pointer, std::align_val_t(kAlignment));
+    }
+
+    template <class U>
+    bool operator==(const ColumnAllocator<U>&) const noexcept {
+        return true;
+    }
+    template <class U>
+    bool operator!=(const ColumnAllocator<U>&) const noexcept {
+        return false;
+    }
+};
+
+//! A column of UnitColumns.
+template <class T>
+using UnitColumn = std::vector<T, ColumnAllocator<T>>;
+
+//! The fields of a list of units stored field by field, so that a query over a field of all units reads contiguous
+//! memory instead of a cache line per unit. Row i of every column describes units[i].
+//!
+//! The columns are padded to a multiple of kLanes rows so that they can be processed a full vector at a time. Padding
+//! rows have NaN coordinates and no alliance, they never match a query.
+struct UnitColumns {
+    //! Number of rows the columns are padded to a multiple of.
+    static constexpr size_t kLanes = 8;
+
+    //! The units, in the order of the rows.
+    Units units;
+
+    //! Unit::tag.
+    UnitColumn<Tag> tag;
+    //! Unit::unit_type.
+    UnitColumn<uint32_t> unit_type;
+    //! Unit::alliance, 0 for padding rows.
+    UnitColumn<int32_t> alliance;
+    //! Unit::pos.
+    UnitColumn<float> x;
+    UnitColumn<float> y;
+    UnitColumn<float> z;
+    //! Unit::radius.
+    UnitColumn<float> radius;
+    //! Unit::health.
+    UnitColumn<float> health;
+    //! Unit::shield.
+    UnitColumn<float> shield;
+    //! Unit::energy.
+    UnitColumn<float> energy;
+    //! Unit::weapon_cooldown.
+    UnitColumn<float> weapon_cooldown;
+
+    //! Copies the fields of the units, reusing the storage of the columns.
+    //!< \param units The units to copy.
+    void Assign(const Units& units);
+
+    //! Forgets all units.
+    void Clear();
+
+    //! Number of units, without the padding rows.
+    size_t Size() const {
+        return units.size();
+    }
+
+    //! Appends the units whose center lies within radius of the point in the XY plane, as DistanceSquared2D(center,
+    //! unit->pos) <= radius * radius would.
+    //!< \param center The center of the range.
+    //!< \param radius The radius of the range.
+    //!< \param units The list to append the units to.
+    void GetUnitsInRange(const Point2D& center, float radius, Units& units) const;
+
+    //! Same as GetUnitsInRange(const Point2D&, float, Units&) for the units of an alliance only.
+    //!< \param center The center of the range.
+    //!< \param radius The radius of the range.
+    //!< \param alliance The alliance of the units.
+    //!< \param units The list to append the units to.
+    void GetUnitsInRange(const Point2D& center, float radius, Unit::Alliance alliance, Units& units) const;
+
+    //! The unit whose center is the closest to the point in the XY plane. Of equally distant units the first one is
+    //! returned.
+    //!< \param point The point to measure the distance from.
+    //!< \return The closest unit, null if there is none.
+    const Unit* GetNearestUnit(const Point2D& point) const;
+
+    //! Same as GetNearestUnit(const Point2D&) for the units of an alliance only.
+    //!< \param point The point to measure the distance from.
+    //!< \param alliance The alliance of the units.
+    //!< \return The closest unit, null if there is none.
+    const Unit* GetNearestUnit(const Point2D& point, Unit::Alliance alliance) const;
+};
+
+}  // namespace sc2
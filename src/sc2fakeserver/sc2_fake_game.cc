@@ -0,0 +1,535 @@
+#include "sc2_fake_game.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+#include "sc2api/sc2_capture.h"
+#include "sc2api/sc2_typeenums.h"
+
+namespace sc2 {
+
+namespace {
+
+// Version reported by the fake game, replays report the same one so they never need another game version.
+const uint32_t kBaseBuild = 93333;
+const char kDataVersion[] = "FAKE93333";
+
+// No building fits closer than this to a resource.
+const int kResourceClearance = 6;
+
+const float kPi = 3.14159265F;
+
+struct Point {
+    float x;
+    float y;
+};
+
+Point GetBaseLocation(const FakeGameSettings& settings, int base) {
+    const float angle = 2.0F * kPi * base / settings.base_count;
+    const float center = settings.map_size / 2.0F;
+    const float radius = 0.4F * settings.map_size;
+    return {center + radius * std::cos(angle), center + radius * std::sin(angle)};
+}
+
+void SetImage(const FakeGameSettings& settings, SC2APIProtocol::ImageData* image, int bits_per_pixel, char value) {
+    image->set_bits_per_pixel(bits_per_pixel);
+    image->mutable_size()->set_x(settings.map_size);
+    image->mutable_size()->set_y(settings.map_size);
+    image->set_data(std::string(settings.map_size * settings.map_size * bits_per_pixel / 8, value));
+}
+
+SC2APIProtocol::Response CreateGameInfo(const FakeGameSettings& settings) {
+    SC2APIProtocol::Response response;
+    SC2APIProtocol::ResponseGameInfo* game_info = response.mutable_game_info();
+    game_info->set_map_name("Synthetic");
+    game_info->set_local_map_path("Synthetic.SC2Map");
+
+    SC2APIProtocol::PlayerInfo* self = game_info->add_player_info();
+    self->set_player_id(1);
+    self->set_type(SC2APIProtocol::Participant);
+    self->set_race_requested(SC2APIProtocol::Terran);
+    self->set_race_actual(SC2APIProtocol::Terran);
+    SC2APIProtocol::PlayerInfo* enemy = game_info->add_player_info();
+    enemy->set_player_id(2);
+    enemy->set_type(SC2APIProtocol::Computer);
+    enemy->set_race_requested(SC2APIProtocol::Zerg);
+    enemy->set_race_actual(SC2APIProtocol::Zerg);
+
+    SC2APIProtocol::StartRaw* start_raw = game_info->mutable_start_raw();
+    start_raw->mutable_map_size()->set_x(settings.map_size);
+    start_raw->mutable_map_size()->set_y(settings.map_size);
+    SetImage(settings, start_raw->mutable_pathing_grid(), 1, '\xff');
+    SetImage(settings, start_raw->mutable_placement_grid(), 1, '\xff');
+    SetImage(settings, start_raw->mutable_terrain_height(), 8, '\xa0');
+    start_raw->mutable_playable_area()->mutable_p0()->set_x(0);
+    start_raw->mutable_playable_area()->mutable_p0()->set_y(0);
+    start_raw->mutable_playable_area()->mutable_p1()->set_x(settings.map_size);
+    start_raw->mutable_playable_area()->mutable_p1()->set_y(settings.map_size);
+    const Point enemy_start = GetBaseLocation(settings, settings.base_count / 2);
+    SC2APIProtocol::Point2D* start_location = start_raw->add_start_locations();
+    start_location->set_x(enemy_start.x);
+    start_location->set_y(enemy_start.y);
+
+    SC2APIProtocol::InterfaceOptions* options = game_info->mutable_options();
+    options->set_raw(true);
+    options->set_score(true);
+    return response;
+}
+
+SC2APIProtocol::Response CreateData() {
+    SC2APIProtocol::Response response;
+    SC2APIProtocol::ResponseData* data = response.mutable_data();
+    for (uint32_t i = 0; i < 4000; ++i) {
+        SC2APIProtocol::AbilityData* ability = data->add_abilities();
+        ability->set_ability_id(i);
+        ability->set_available(true);
+        // A share of the abilities remap to a general one, like the attack abilities of each unit.
+        if (i % 50 == 1) {
+            ability->set_remaps_to_ability_id(i - 1);
+        }
+    }
+
+    for (uint32_t i = 0; i < 2000; ++i) {
+        SC2APIProtocol::UnitTypeData* unit_type = data->add_units();
+        unit_type->set_unit_id(i);
+        unit_type->set_available(true);
+    }
+
+    return response;
+}
+
+void AddUnit(SC2APIProtocol::ObservationRaw* raw, std::mt19937& generator, SC2APIProtocol::Alliance alliance,
+             UNIT_TYPEID type, const Point& pos, uint64_t tag) {
+    std::uniform_real_distribution<float> unit_value(0.0F, 1.0F);
+
+    SC2APIProtocol::Unit* unit = raw->add_units();
+    unit->set_display_type(SC2APIProtocol::Visible);
+    unit->set_alliance(alliance);
+    unit->set_tag(tag);
+    unit->set_unit_type(static_cast<uint32_t>(type));
+    unit->set_owner(alliance == SC2APIProtocol::Self ? 1 : (alliance == SC2APIProtocol::Enemy ? 2 : 16));
+    unit->mutable_pos()->set_x(pos.x);
+    unit->mutable_pos()->set_y(pos.y);
+    unit->mutable_pos()->set_z(10.0F);
+    unit->set_facing(unit_value(generator) * 2.0F * kPi);
+    unit->set_radius(0.5F);
+    unit->set_build_progress(1.0F);
+    unit->set_health(40.0F * unit_value(generator) + 5.0F);
+    unit->set_health_max(45.0F);
+
+    if (alliance == SC2APIProtocol::Neutral) {
+        unit->set_mineral_contents(type == UNIT_TYPEID::NEUTRAL_MINERALFIELD ? 1800 : 0);
+        unit->set_vespene_contents(type == UNIT_TYPEID::NEUTRAL_VESPENEGEYSER ? 2250 : 0);
+        return;
+    }
+
+    unit->set_weapon_cooldown(unit_value(generator));
+    if (unit_value(generator) < 0.6F) {
+        SC2APIProtocol::UnitOrder* order = unit->add_orders();
+        order->set_ability_id(unit_value(generator) < 0.5F ? 23 : 16);
+        order->mutable_target_world_space_pos()->set_x(pos.x + 5.0F);
+        order->mutable_target_world_space_pos()->set_y(pos.y + 5.0F);
+    }
+    if (unit_value(generator) < 0.1F) {
+        unit->add_buff_ids(27);
+    }
+}
+
+SC2APIProtocol::Response CreateObservation(const FakeGameSettings& settings) {
+    std::mt19937 generator(settings.seed);
+    std::normal_distribution<float> spread(0.0F, 8.0F);
+
+    SC2APIProtocol::Response response;
+    SC2APIProtocol::ResponseObservation* response_observation = response.mutable_observation();
+    SC2APIProtocol::Observation* observation = response_observation->mutable_observation();
+    observation->set_game_loop(1);
+    SC2APIProtocol::PlayerCommon* player_common = observation->mutable_player_common();
+    player_common->set_player_id(1);
+    player_common->set_minerals(500);
+    player_common->set_food_used(settings.own_units);
+    player_common->set_food_cap(200);
+    observation->mutable_score()->set_score_type(SC2APIProtocol::Score::Melee);
+    observation->mutable_score()->set_score(1000 + settings.own_units);
+
+    SC2APIProtocol::ObservationRaw* raw = observation->mutable_raw_data();
+    uint64_t tag = 0x100000001ULL;
+
+    // Every base has a mineral line facing away from the center of the map and two geysers.
+    const float center = settings.map_size / 2.0F;
+    const float radius = 0.4F * settings.map_size;
+    for (int base = 0; base < settings.base_count; ++base) {
+        const Point location = GetBaseLocation(settings, base);
+        const Point outward = {(location.x - center) / radius, (location.y - center) / radius};
+        for (int i = 0; i < 8; ++i) {
+            const float angle = -0.8F + 0.2F * i;
+            const Point direction = {outward.x * std::cos(angle) - outward.y * std::sin(angle),
+                                     outward.x * std::sin(angle) + outward.y * std::cos(angle)};
+            AddUnit(raw, generator, SC2APIProtocol::Neutral, UNIT_TYPEID::NEUTRAL_MINERALFIELD,
+                    {location.x + direction.x * 7.0F, location.y + direction.y * 7.0F}, tag++);
+        }
+        AddUnit(raw, generator, SC2APIProtocol::Neutral, UNIT_TYPEID::NEUTRAL_VESPENEGEYSER,
+                {location.x + outward.y * 7.0F, location.y - outward.x * 7.0F}, tag++);
+        AddUnit(raw, generator, SC2APIProtocol::Neutral, UNIT_TYPEID::NEUTRAL_VESPENEGEYSER,
+                {location.x - outward.y * 7.0F, location.y + outward.x * 7.0F}, tag++);
+    }
+
+    static const UNIT_TYPEID own_types[] = {UNIT_TYPEID::TERRAN_SCV, UNIT_TYPEID::TERRAN_MARINE,
+                                            UNIT_TYPEID::TERRAN_MARAUDER, UNIT_TYPEID::TERRAN_SUPPLYDEPOT};
+    static const UNIT_TYPEID enemy_types[] = {UNIT_TYPEID::ZERG_DRONE, UNIT_TYPEID::ZERG_ZERGLING,
+                                              UNIT_TYPEID::ZERG_ROACH, UNIT_TYPEID::ZERG_OVERLORD};
+
+    // Armies gather around the bases of their owner, a town hall at each.
+    const int own_bases = 1 + settings.own_units / 80;
+    for (int i = 0; i < settings.own_units; ++i) {
+        const Point base = GetBaseLocation(settings, i % own_bases);
+        const UNIT_TYPEID type = i < own_bases ? UNIT_TYPEID::TERRAN_COMMANDCENTER : own_types[i % 4];
+        AddUnit(raw, generator, SC2APIProtocol::Self, type, {base.x + spread(generator), base.y + spread(generator)},
+                tag++);
+    }
+
+    const int enemy_bases = 1 + settings.enemy_units / 80;
+    for (int i = 0; i < settings.enemy_units; ++i) {
+        const Point base = GetBaseLocation(settings, settings.base_count / 2 + i % enemy_bases);
+        const UNIT_TYPEID type = i < enemy_bases ? UNIT_TYPEID::ZERG_HATCHERY : enemy_types[i % 4];
+        AddUnit(raw, generator, SC2APIProtocol::Enemy, type, {base.x + spread(generator), base.y + spread(generator)},
+                tag++);
+    }
+
+    SC2APIProtocol::MapState* map_state = raw->mutable_map_state();
+    SetImage(settings, map_state->mutable_visibility(), 8, '\x02');
+    SetImage(settings, map_state->mutable_creep(), 1, '\x0f');
+
+    for (int i = 0; i < settings.actions && i < raw->units_size(); ++i) {
+        SC2APIProtocol::ActionRawUnitCommand* command =
+            response_observation->add_actions()->mutable_action_raw()->mutable_unit_command();
+        command->set_ability_id(23);
+        command->add_unit_tags(raw->units(raw->units_size() - 1 - i).tag());
+        command->mutable_target_world_space_pos()->set_x(center);
+        command->mutable_target_world_space_pos()->set_y(center);
+    }
+
+    return response;
+}
+
+SC2APIProtocol::Response CreateReplayInfo(const FakeGameSettings& settings) {
+    SC2APIProtocol::Response response;
+    SC2APIProtocol::ResponseReplayInfo* replay_info = response.mutable_replay_info();
+    replay_info->set_map_name("Synthetic");
+    replay_info->set_local_map_path("Synthetic.SC2Map");
+    replay_info->set_game_duration_loops(settings.game_loops ? settings.game_loops : 20000);
+    replay_info->set_game_duration_seconds(replay_info->game_duration_loops() / 22.4F);
+    replay_info->set_game_version("5.0.14");
+    replay_info->set_data_version(kDataVersion);
+    replay_info->set_base_build(kBaseBuild);
+    replay_info->set_data_build(kBaseBuild);
+
+    for (uint32_t player_id = 1; player_id <= 2; ++player_id) {
+        SC2APIProtocol::PlayerInfoExtra* player = replay_info->add_player_info();
+        player->mutable_player_info()->set_player_id(player_id);
+        player->mutable_player_info()->set_type(SC2APIProtocol::Participant);
+        player->mutable_player_info()->set_race_requested(player_id == 1 ? SC2APIProtocol::Terran
+                                                                         : SC2APIProtocol::Zerg);
+        player->mutable_player_info()->set_race_actual(player->player_info().race_requested());
+        player->mutable_player_result()->set_player_id(player_id);
+        player->mutable_player_result()->set_result(player_id == 1 ? SC2APIProtocol::Victory : SC2APIProtocol::Defeat);
+        player->set_player_mmr(3000);
+        player->set_player_apm(120);
+    }
+
+    return response;
+}
+
+}  // namespace
+
+FakeGame::FakeGame(const FakeGameSettings& settings)
+    : settings_(settings), status_(SC2APIProtocol::launched), game_loop_(0), width_(0), height_(0) {
+    SetResponse(CreateGameInfo(settings_));
+    SetResponse(CreateData());
+    SetResponse(CreateObservation(settings_));
+    SetResponse(CreateReplayInfo(settings_));
+
+    SC2APIProtocol::Response ping;
+    ping.mutable_ping()->set_game_version("5.0.14");
+    ping.mutable_ping()->set_data_version(kDataVersion);
+    ping.mutable_ping()->set_data_build(kBaseBuild);
+    ping.mutable_ping()->set_base_build(kBaseBuild);
+    SetResponse(ping);
+}
+
+bool FakeGame::LoadCapture(const std::string& path) {
+    CaptureReader reader;
+    if (!reader.Open(path)) {
+        return false;
+    }
+
+    std::map<int, Templates> recorded;
+    CaptureRecord record;
+    while (reader.Next(record)) {
+        if (record.direction == CaptureDirection::Response && record.type != 0) {
+            recorded[record.type].responses.emplace_back(record.data, record.size);
+        }
+    }
+
+    if (recorded.empty()) {
+        return false;
+    }
+
+    for (auto& templates : recorded) {
+        templates_[templates.first] = std::move(templates.second);
+    }
+
+    UpdateBlockedCells();
+    return true;
+}
+
+void FakeGame::SetResponse(const SC2APIProtocol::Response& response) {
+    Templates& templates = templates_[response.response_case()];
+    templates.responses.assign(1, response.SerializeAsString());
+    templates.next = 0;
+
+    if (response.has_game_info() || response.has_observation()) {
+        UpdateBlockedCells();
+    }
+}
+
+SC2APIProtocol::Response FakeGame::GetResponse(SC2APIProtocol::Response::ResponseCase response_case) const {
+    SC2APIProtocol::Response response;
+    auto found = templates_.find(response_case);
+    if (found != templates_.end() && !found->second.responses.empty()) {
+        response.ParseFromString(found->second.responses.front());
+    }
+
+    return response;
+}
+
+bool FakeGame::Answer(const SC2APIProtocol::Request& request, std::string& response) {
+    if (settings_.latency_us > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(settings_.latency_us));
+    }
+
+    // Serialized messages concatenate into their merge, so the answer is the serialized template followed by the
+    // fields that change. Scalars of the tail override those of the template and submessages merge.
+    SC2APIProtocol::Response tail;
+    bool supported = true;
+    response.clear();
+    switch (request.request_case()) {
+        case SC2APIProtocol::Request::kCreateGame:
+            status_ = SC2APIProtocol::init_game;
+            tail.mutable_create_game();
+            break;
+        case SC2APIProtocol::Request::kJoinGame:
+            status_ = SC2APIProtocol::in_game;
+            game_loop_ = 1;
+            tail.mutable_join_game()->set_player_id(1);
+            break;
+        case SC2APIProtocol::Request::kRestartGame:
+            status_ = SC2APIProtocol::in_game;
+            game_loop_ = 1;
+            tail.mutable_restart_game();
+            break;
+        case SC2APIProtocol::Request::kStartReplay:
+            status_ = SC2APIProtocol::in_replay;
+            game_loop_ = 1;
+            tail.mutable_start_replay();
+            break;
+        case SC2APIProtocol::Request::kLeaveGame:
+            status_ = SC2APIProtocol::launched;
+            tail.mutable_leave_game();
+            break;
+        case SC2APIProtocol::Request::kQuickSave:
+            tail.mutable_quick_save();
+            break;
+        case SC2APIProtocol::Request::kQuickLoad:
+            tail.mutable_quick_load();
+            break;
+        case SC2APIProtocol::Request::kQuit:
+            status_ = SC2APIProtocol::quit;
+            tail.mutable_quit();
+            break;
+        case SC2APIProtocol::Request::kGameInfo:
+        case SC2APIProtocol::Request::kData:
+        case SC2APIProtocol::Request::kReplayInfo:
+        case SC2APIProtocol::Request::kPing:
+            response = NextTemplate(SC2APIProtocol::Response::ResponseCase(request.request_case()));
+            break;
+        case SC2APIProtocol::Request::kObservation: {
+            response = NextTemplate(SC2APIProtocol::Response::kObservation);
+            SC2APIProtocol::ResponseObservation* response_observation = tail.mutable_observation();
+            response_observation->mutable_observation()->set_game_loop(game_loop_);
+            if (status_ == SC2APIProtocol::ended) {
+                SC2APIProtocol::PlayerResult* player_result = response_observation->add_player_result();
+                player_result->set_player_id(1);
+                player_result->set_result(SC2APIProtocol::Victory);
+            }
+            break;
+        }
+        case SC2APIProtocol::Request::kStep:
+            if (status_ == SC2APIProtocol::in_game || status_ == SC2APIProtocol::in_replay) {
+                game_loop_ += std::max(request.step().count(), 1U);
+                if (settings_.game_loops > 0 && game_loop_ >= settings_.game_loops) {
+                    status_ = SC2APIProtocol::ended;
+                }
+            }
+            tail.mutable_step()->set_simulation_loop(game_loop_);
+            break;
+        case SC2APIProtocol::Request::kAction: {
+            SC2APIProtocol::ResponseAction* response_action = tail.mutable_action();
+            for (int i = 0; i < request.action().actions_size(); ++i) {
+                response_action->add_result(SC2APIProtocol::Success);
+            }
+            break;
+        }
+        case SC2APIProtocol::Request::kObsAction:
+            tail.mutable_obs_action();
+            break;
+        case SC2APIProtocol::Request::kQuery:
+            AnswerQuery(request.query(), *tail.mutable_query());
+            break;
+        case SC2APIProtocol::Request::kSaveReplay:
+            tail.mutable_save_replay();
+            break;
+        case SC2APIProtocol::Request::kMapCommand:
+            tail.mutable_map_command();
+            break;
+        case SC2APIProtocol::Request::kAvailableMaps:
+            tail.mutable_available_maps()->add_local_map_paths("Synthetic.SC2Map");
+            break;
+        case SC2APIProtocol::Request::kSaveMap:
+            tail.mutable_save_map();
+            break;
+        case SC2APIProtocol::Request::kDebug:
+            tail.mutable_debug();
+            break;
+        default:
+            tail.add_error("The fake game doesn't support the request.");
+            supported = false;
+            break;
+    }
+
+    tail.set_id(request.id());
+    tail.set_status(status_);
+    tail.AppendToString(&response);
+    return supported;
+}
+
+SC2APIProtocol::Response* FakeGame::Answer(const SC2APIProtocol::Request& request) {
+    std::string serialized;
+    Answer(request, serialized);
+
+    SC2APIProtocol::Response* response = new SC2APIProtocol::Response();
+    response->ParseFromString(serialized);
+    return response;
+}
+
+const std::string& FakeGame::NextTemplate(SC2APIProtocol::Response::ResponseCase response_case) {
+    static const std::string empty;
+    auto found = templates_.find(response_case);
+    if (found == templates_.end() || found->second.responses.empty()) {
+        return empty;
+    }
+
+    Templates& templates = found->second;
+    const std::string& response = templates.responses[templates.next];
+    templates.next = (templates.next + 1) % templates.responses.size();
+    return response;
+}
+
+const std::string& FakeGame::CurrentTemplate(SC2APIProtocol::Response::ResponseCase response_case) const {
+    static const std::string empty;
+    auto found = templates_.find(response_case);
+    if (found == templates_.end() || found->second.responses.empty()) {
+        return empty;
+    }
+
+    // The template answered last, templates are answered in a cycle.
+    const Templates& templates = found->second;
+    return templates.responses[(templates.next + templates.responses.size() - 1) % templates.responses.size()];
+}
+
+void FakeGame::AnswerQuery(const SC2APIProtocol::RequestQuery& request_query,
+                           SC2APIProtocol::ResponseQuery& response_query) {
+    // Positions of the units of the observation last answered, for paths starting from a unit.
+    std::unordered_map<uint64_t, SC2APIProtocol::Point> unit_positions;
+    bool units_parsed = false;
+
+    for (const SC2APIProtocol::RequestQueryPathing& pathing : request_query.pathing()) {
+        // Straight paths, the map has no obstacles.
+        const SC2APIProtocol::Point2D& end = pathing.end_pos();
+        float start_x = end.x();
+        float start_y = end.y();
+        if (pathing.has_start_pos()) {
+            start_x = pathing.start_pos().x();
+            start_y = pathing.start_pos().y();
+        } else if (pathing.has_unit_tag()) {
+            if (!units_parsed) {
+                SC2APIProtocol::Response observation;
+                observation.ParseFromString(CurrentTemplate(SC2APIProtocol::Response::kObservation));
+                for (const SC2APIProtocol::Unit& unit : observation.observation().observation().raw_data().units()) {
+                    unit_positions[unit.tag()] = unit.pos();
+                }
+                units_parsed = true;
+            }
+
+            auto found = unit_positions.find(pathing.unit_tag());
+            if (found == unit_positions.end()) {
+                // The game answers a distance of 0 when no path leads to the target.
+                response_query.add_pathing()->set_distance(0.0F);
+                continue;
+            }
+            start_x = found->second.x();
+            start_y = found->second.y();
+        }
+        response_query.add_pathing()->set_distance(std::hypot(end.x() - start_x, end.y() - start_y));
+    }
+
+    for (const SC2APIProtocol::RequestQueryAvailableAbilities& abilities : request_query.abilities()) {
+        response_query.add_abilities()->set_unit_tag(abilities.unit_tag());
+    }
+
+    for (const SC2APIProtocol::RequestQueryBuildingPlacement& placement : request_query.placements()) {
+        const bool placable = IsPlacable(placement.target_pos().x(), placement.target_pos().y());
+        response_query.add_placements()->set_result(placable ? SC2APIProtocol::Success : SC2APIProtocol::Error);
+    }
+}
+
+void FakeGame::UpdateBlockedCells() {
+    const SC2APIProtocol::Response game_info = GetResponse(SC2APIProtocol::Response::kGameInfo);
+    const SC2APIProtocol::Response observation = GetResponse(SC2APIProtocol::Response::kObservation);
+
+    width_ = game_info.game_info().start_raw().map_size().x();
+    height_ = game_info.game_info().start_raw().map_size().y();
+    blocked_.assign(static_cast<size_t>(width_) * height_, false);
+
+    for (const SC2APIProtocol::Unit& unit : observation.observation().observation().raw_data().units()) {
+        if (unit.alliance() != SC2APIProtocol::Neutral) {
+            continue;
+        }
+
+        for (int y = -kResourceClearance; y <= kResourceClearance; ++y) {
+            for (int x = -kResourceClearance; x <= kResourceClearance; ++x) {
+                const int cell_x = static_cast<int>(unit.pos().x()) + x;
+                const int cell_y = static_cast<int>(unit.pos().y()) + y;
+                if (x * x + y * y <= kResourceClearance * kResourceClearance && cell_x >= 0 && cell_y >= 0 &&
+                    cell_x < width_ && cell_y < height_) {
+                    blocked_[cell_x + static_cast<size_t>(cell_y) * width_] = true;
+                }
+            }
+        }
+    }
+}
+
+bool FakeGame::IsPlacable(float x, float y) const {
+    const int cell_x = static_cast<int>(x);
+    const int cell_y = static_cast<int>(y);
+    if (x < 0.0F || y < 0.0F || cell_x >= width_ || cell_y >= height_) {
+        return false;
+    }
+
+    return !blocked_[cell_x + static_cast<size_t>(cell_y) * width_];
+}
+
+}  // namespace sc2
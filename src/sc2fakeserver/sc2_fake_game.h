@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "s2clientprotocol/sc2api.pb.h"
+
+namespace sc2 {
+
+// Shape of the synthetic game answered when no capture is loaded.
+struct FakeGameSettings {
+    // Width and height of the map in cells.
+    int map_size = 200;
+    // Expansions spread evenly on a circle, each with 8 mineral fields and 2 geysers.
+    int base_count = 16;
+    // Units of the observing player and of the enemy, besides the resources.
+    int own_units = 230;
+    int enemy_units = 120;
+    // Raw actions reported in every observation, as in the observations of a replay.
+    int actions = 0;
+    // Game loops until the game ends, the game never ends if 0.
+    uint32_t game_loops = 0;
+    // Delay added before answering each request, in microseconds.
+    unsigned int latency_us = 0;
+    // Seed of the generator of the synthetic units.
+    uint32_t seed = 1;
+};
+
+// Stand-in for the game: answers requests from recorded or synthetic responses and keeps just enough state for a
+// client to go through a whole game. Create and join a game, step it and observe it, start replays, leave and quit.
+// Observations always come from the same few templates with an advancing game loop, so answering one is cheap no matter
+// the number of units.
+class FakeGame {
+public:
+    explicit FakeGame(const FakeGameSettings& settings = FakeGameSettings());
+
+    // Answers with the responses recorded in a capture, see CaptureWriter. Responses of each type are replayed in the
+    // order they were recorded and start over once exhausted, types missing from the capture stay synthetic.
+    bool LoadCapture(const std::string& path);
+
+    // Answers requests of the type of the response with the given response only.
+    void SetResponse(const SC2APIProtocol::Response& response);
+
+    // The first response answered for requests of the given type, e.g. to inspect the observation template.
+    SC2APIProtocol::Response GetResponse(SC2APIProtocol::Response::ResponseCase response_case) const;
+
+    // Answers a request with a serialized response. Returns false if the request type isn't supported, the response
+    // then holds an error.
+    bool Answer(const SC2APIProtocol::Request& request, std::string& response);
+
+    // Same as above but parses the response, which has to be freed with delete.
+    SC2APIProtocol::Response* Answer(const SC2APIProtocol::Request& request);
+
+    const FakeGameSettings& GetSettings() const {
+        return settings_;
+    }
+    uint32_t GetGameLoop() const {
+        return game_loop_;
+    }
+    SC2APIProtocol::Status GetStatus() const {
+        return status_;
+    }
+
+private:
+    // Recorded or synthetic responses of one type.
+    struct Templates {
+        std::vector<std::string> responses;
+        size_t next = 0;
+    };
+
+    const std::string& NextTemplate(SC2APIProtocol::Response::ResponseCase response_case);
+    const std::string& CurrentTemplate(SC2APIProtocol::Response::ResponseCase response_case) const;
+    void AnswerQuery(const SC2APIProtocol::RequestQuery& request_query, SC2APIProtocol::ResponseQuery& response_query);
+    void UpdateBlockedCells();
+    bool IsPlacable(float x, float y) const;
+
+    FakeGameSettings settings_;
+    std::map<int, Templates> templates_;
+    SC2APIProtocol::Status status_;
+    uint32_t game_loop_;
+
+    // Cells too close to resources to place a building, the placement grid of the game info is ignored.
+    int width_;
+    int height_;
+    std::vector<bool> blocked_;
+};
+
+}  // namespace sc2
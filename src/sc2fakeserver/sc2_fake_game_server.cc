@@ -0,0 +1,58 @@
+#include "sc2_fake_game_server.h"
+
+#include "sc2api/sc2_server.h"
+
+namespace sc2 {
+
+FakeGameServer::FakeGameServer(const FakeGameSettings& settings)
+    : game_(settings), running_(false), request_count_(0) {
+}
+
+FakeGameServer::~FakeGameServer() {
+    Stop();
+}
+
+bool FakeGameServer::Start(int port) {
+    Stop();
+
+    server_ = std::make_unique<Server>();
+    const std::string listening_port = std::to_string(port);
+    if (!server_->Listen(listening_port.c_str(), "100000", "100000", "2")) {
+        server_.reset();
+        return false;
+    }
+
+    running_ = true;
+    request_count_ = 0;
+    thread_ = std::thread(&FakeGameServer::Run, this);
+    return true;
+}
+
+void FakeGameServer::Stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    server_.reset();
+}
+
+void FakeGameServer::Run() {
+    // Responses are serialized into the same buffer every time.
+    std::string response;
+    while (running_) {
+        if (!server_->WaitForRequest(100)) {
+            continue;
+        }
+
+        RequestData request;
+        while (server_->PopRequest(request)) {
+            game_.Answer(*request.second, response);
+            server_->SendResponse(request.first, response.data(), response.size());
+            delete request.second;
+            ++request_count_;
+        }
+    }
+}
+
+}  // namespace sc2
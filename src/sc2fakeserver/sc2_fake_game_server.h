@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "sc2_fake_game.h"
+
+namespace sc2 {
+
+class Server;
+
+// Serves a FakeGame over the websocket protocol of the game, clients connect to it the same way they attach to a
+// running game. Hermetic stand-in to load test the client stack without a game binary.
+class FakeGameServer {
+public:
+    explicit FakeGameServer(const FakeGameSettings& settings = FakeGameSettings());
+    ~FakeGameServer();
+
+    FakeGameServer(const FakeGameServer&) = delete;
+    FakeGameServer& operator=(const FakeGameServer&) = delete;
+
+    // The game answering the requests, configure it before starting the server.
+    FakeGame& Game() {
+        return game_;
+    }
+
+    // Listens on the given port and answers requests on a thread of its own until stopped.
+    bool Start(int port);
+    void Stop();
+    bool IsRunning() const {
+        return running_;
+    }
+
+    // Number of requests answered since the server started.
+    uint64_t GetRequestCount() const {
+        return request_count_;
+    }
+
+private:
+    void Run();
+
+    FakeGame game_;
+    std::unique_ptr<Server> server_;
+    std::thread thread_;
+    std::atomic_bool running_;
+    std::atomic<uint64_t> request_count_;
+};
+
+}  // namespace sc2
@@ -1,4 +1,5 @@
 #pragma once
 
 #include "sc2_search.h"
+#include "sc2_spatial_index.h"
 #include "sc2_utils.h"
@@ -0,0 +1,233 @@
+#include "sc2_spatial_index.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace sc2 {
+
+UnitSpatialIndex::UnitSpatialIndex(float cell_size) : cell_size_(cell_size), columns_(0), rows_(0) {
+    assert(cell_size_ > 0.0F);
+}
+
+void UnitSpatialIndex::Update(const ObservationInterface* observation) {
+    observed_.clear();
+    observation->GetUnits(observed_);
+    Update(observed_);
+}
+
+void UnitSpatialIndex::Update(const Units& units) {
+    units_.clear();
+
+    if (units.empty()) {
+        columns_ = 0;
+        rows_ = 0;
+        cell_start_.assign(1, 0);
+        return;
+    }
+
+    Point2D min(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+    Point2D max(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+    for (const Unit* unit : units) {
+        min.x = std::min(min.x, unit->pos.x);
+        min.y = std::min(min.y, unit->pos.y);
+        max.x = std::max(max.x, unit->pos.x);
+        max.y = std::max(max.y, unit->pos.y);
+    }
+
+    origin_ = min;
+    columns_ = static_cast<int>((max.x - min.x) / cell_size_) + 1;
+    rows_ = static_cast<int>((max.y - min.y) / cell_size_) + 1;
+
+    // Counting sort of the units by cell.
+    const size_t cell_count = static_cast<size_t>(columns_) * rows_;
+    cell_start_.assign(cell_count + 1, 0);
+    unit_cells_.resize(units.size());
+    for (size_t i = 0; i < units.size(); ++i) {
+        const size_t cell = CellX(units[i]->pos.x) + static_cast<size_t>(CellY(units[i]->pos.y)) * columns_;
+        unit_cells_[i] = cell;
+        ++cell_start_[cell + 1];
+    }
+
+    for (size_t i = 1; i < cell_start_.size(); ++i) {
+        cell_start_[i] += cell_start_[i - 1];
+    }
+
+    cell_fill_.assign(cell_start_.begin(), cell_start_.end() - 1);
+    units_.resize(units.size());
+    for (size_t i = 0; i < units.size(); ++i) {
+        units_[cell_fill_[unit_cells_[i]]++] = units[i];
+    }
+}
+
+Units UnitSpatialIndex::GetUnitsInRadius(const Point2D& center, float radius, Filter filter) const {
+    Units units;
+    CollectInBox(center - Point2D(radius, radius), center + Point2D(radius, radius), kAnyAlliance, filter,
+                 radius * radius, center, units);
+    return units;
+}
+
+Units UnitSpatialIndex::GetUnitsInRadius(const Point2D& center, float radius, Unit::Alliance alliance,
+                                         Filter filter) const {
+    Units units;
+    CollectInBox(center - Point2D(radius, radius), center + Point2D(radius, radius), alliance, filter, radius * radius,
+                 center, units);
+    return units;
+}
+
+Units UnitSpatialIndex::GetUnitsInBox(const Rect2D& box, Filter filter) const {
+    Units units;
+    CollectInBox(box.from, box.to, kAnyAlliance, filter, -1.0F, Point2D(), units);
+    return units;
+}
+
+Units UnitSpatialIndex::GetUnitsInBox(const Rect2D& box, Unit::Alliance alliance, Filter filter) const {
+    Units units;
+    CollectInBox(box.from, box.to, alliance, filter, -1.0F, Point2D(), units);
+    return units;
+}
+
+Units UnitSpatialIndex::GetNearestUnits(const Point2D& point, size_t count, Filter filter) const {
+    return CollectNearest(point, count, kAnyAlliance, filter);
+}
+
+Units UnitSpatialIndex::GetNearestUnits(const Point2D& point, size_t count, Unit::Alliance alliance,
+                                        Filter filter) const {
+    return CollectNearest(point, count, alliance, filter);
+}
+
+size_t UnitSpatialIndex::Size() const {
+    return units_.size();
+}
+
+// A negative radius_squared disables the distance check and only the box is tested.
+void UnitSpatialIndex::CollectInBox(const Point2D& min, const Point2D& max, int alliance, const Filter& filter,
+                                    float radius_squared, const Point2D& center, Units& units) const {
+    if (units_.empty()) {
+        return;
+    }
+
+    // The box may lie partly or entirely outside of the grid, only the cells it shares with the grid are visited.
+    const int from_x = std::max(CellX(min.x), 0);
+    const int from_y = std::max(CellY(min.y), 0);
+    const int to_x = std::min(CellX(max.x), columns_ - 1);
+    const int to_y = std::min(CellY(max.y), rows_ - 1);
+    if (from_x > to_x || from_y > to_y) {
+        return;
+    }
+
+    for (int y = from_y; y <= to_y; ++y) {
+        const size_t row = static_cast<size_t>(y) * columns_;
+        for (size_t i = cell_start_[row + from_x], e = cell_start_[row + to_x + 1]; i < e; ++i) {
+            const Unit& unit = *units_[i];
+            if (radius_squared < 0.0F) {
+                if (unit.pos.x < min.x || unit.pos.x > max.x || unit.pos.y < min.y || unit.pos.y > max.y) {
+                    continue;
+                }
+            } else if (DistanceSquared2D(center, unit.pos) > radius_squared) {
+                continue;
+            }
+
+            if (Accept(unit, alliance, filter)) {
+                units.push_back(&unit);
+            }
+        }
+    }
+}
+
+Units UnitSpatialIndex::CollectNearest(const Point2D& point, size_t count, int alliance, const Filter& filter) const {
+    if (units_.empty() || count == 0) {
+        return {};
+    }
+
+    // Max-heap of the best candidates found so far, the farthest one is on top.
+    std::vector<std::pair<float, const Unit*> > best;
+    best.reserve(count + 1);
+
+    auto visit_cell = [&](int x, int y) {
+        if (x < 0 || y < 0 || x >= columns_ || y >= rows_) {
+            return;
+        }
+
+        const size_t cell = x + static_cast<size_t>(y) * columns_;
+        for (size_t i = cell_start_[cell], e = cell_start_[cell + 1]; i < e; ++i) {
+            const Unit& unit = *units_[i];
+            const float distance = DistanceSquared2D(point, unit.pos);
+            if (best.size() == count && distance >= best.front().first) {
+                continue;
+            }
+
+            if (!Accept(unit, alliance, filter)) {
+                continue;
+            }
+
+            best.emplace_back(distance, &unit);
+            std::push_heap(best.begin(), best.end());
+            if (best.size() > count) {
+                std::pop_heap(best.begin(), best.end());
+                best.pop_back();
+            }
+        }
+    };
+
+    // Visit the cells in square rings of growing size around the cell containing the point. Units in ring r + 1 are
+    // at least r cells away, so the search stops once the farthest candidate is closer than that.
+    const int center_x = CellX(point.x);
+    const int center_y = CellY(point.y);
+    const int max_ring =
+        std::max(std::max(center_x, columns_ - 1 - center_x), std::max(center_y, rows_ - 1 - center_y));
+
+    for (int ring = 0; ring <= max_ring; ++ring) {
+        if (ring == 0) {
+            visit_cell(center_x, center_y);
+        } else {
+            for (int x = center_x - ring; x <= center_x + ring; ++x) {
+                visit_cell(x, center_y - ring);
+                visit_cell(x, center_y + ring);
+            }
+            for (int y = center_y - ring + 1; y <= center_y + ring - 1; ++y) {
+                visit_cell(center_x - ring, y);
+                visit_cell(center_x + ring, y);
+            }
+        }
+
+        const float reach = ring * cell_size_;
+        if (best.size() == count && best.front().first <= reach * reach) {
+            break;
+        }
+    }
+
+    std::sort_heap(best.begin(), best.end());
+
+    Units units;
+    units.reserve(best.size());
+    for (const auto& candidate : best) {
+        units.push_back(candidate.second);
+    }
+
+    return units;
+}
+
+bool UnitSpatialIndex::Accept(const Unit& unit, int alliance, const Filter& filter) const {
+    if (alliance != kAnyAlliance && unit.alliance != alliance) {
+        return false;
+    }
+
+    return !filter || filter(unit);
+}
+
+// Positions outside of the grid map to the cells just beyond it, the float is clamped first so that positions far away
+// don't overflow the cast.
+int UnitSpatialIndex::CellX(float x) const {
+    const float cell = std::floor((x - origin_.x) / cell_size_);
+    return static_cast<int>(std::min(std::max(cell, -1.0F), static_cast<float>(columns_)));
+}
+
+int UnitSpatialIndex::CellY(float y) const {
+    const float cell = std::floor((y - origin_.y) / cell_size_);
+    return static_cast<int>(std::min(std::max(cell, -1.0F), static_cast<float>(rows_)));
+}
+
+}  // namespace sc2
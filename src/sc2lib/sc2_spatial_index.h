@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+
+#include "sc2api/sc2_common.h"
+#include "sc2api/sc2_interfaces.h"
+#include "sc2api/sc2_unit.h"
+
+namespace sc2 {
+
+// Uniform grid over the units of an observation. Answers proximity queries by visiting only the cells overlapping the
+// queried area instead of scanning every unit. All distances are measured between unit centers in the XY plane.
+class UnitSpatialIndex {
+public:
+    // Queries touch all cells overlapping their area, so cells roughly the size of a typical query radius work best.
+    explicit UnitSpatialIndex(float cell_size = 4.0F);
+
+    // Rebuilds the index from the units of the current observation. Call once per step after the observation has been
+    // updated, e.g. at the start of OnStep. The storage is reused between steps so rebuilding doesn't allocate once the
+    // unit count has settled.
+    void Update(const ObservationInterface* observation);
+    void Update(const Units& units);
+
+    // Units whose center lies within radius of the given point.
+    Units GetUnitsInRadius(const Point2D& center, float radius, Filter filter = {}) const;
+    Units GetUnitsInRadius(const Point2D& center, float radius, Unit::Alliance alliance, Filter filter = {}) const;
+
+    // Units whose center lies within the box, bounds are inclusive.
+    Units GetUnitsInBox(const Rect2D& box, Filter filter = {}) const;
+    Units GetUnitsInBox(const Rect2D& box, Unit::Alliance alliance, Filter filter = {}) const;
+
+    // Up to count units closest to the given point, sorted by increasing distance.
+    Units GetNearestUnits(const Point2D& point, size_t count, Filter filter = {}) const;
+    Units GetNearestUnits(const Point2D& point, size_t count, Unit::Alliance alliance, Filter filter = {}) const;
+
+    // Number of indexed units.
+    size_t Size() const;
+
+private:
+    // Matches any alliance in the queries below.
+    static const int kAnyAlliance = 0;
+
+    void CollectInBox(const Point2D& min, const Point2D& max, int alliance, const Filter& filter, float radius_squared,
+                      const Point2D& center, Units& units) const;
+    Units CollectNearest(const Point2D& point, size_t count, int alliance, const Filter& filter) const;
+    bool Accept(const Unit& unit, int alliance, const Filter& filter) const;
+    int CellX(float x) const;
+    int CellY(float y) const;
+
+    float cell_size_;
+    Point2D origin_;
+    int columns_;
+    int rows_;
+
+    // Units sorted by cell, the units of cell i are units_[cell_start_[i]] .. units_[cell_start_[i + 1] - 1].
+    std::vector<const Unit*> units_;
+    std::vector<size_t> cell_start_;
+
+    // Scratch buffers kept to avoid allocations on rebuild.
+    Units observed_;
+    std::vector<size_t> unit_cells_;
+    std::vector<size_t> cell_fill_;
+};
+
+}  // namespace sc2
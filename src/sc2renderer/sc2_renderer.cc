@@ -4,6 +4,7 @@
 #include <iostream>
 
 #include "SDL.h"
+#include "sc2api/sc2_image_view.h"
 
 namespace {
 SDL_Window* window_;
@@ -144,6 +145,43 @@ void ImageRGB(const char* bytes, int width, int height, int off_x, int off_y) {
     SDL_DestroyTexture(texture);
 }
 
+void Matrix1BPP(const ImageView& image, int off_x, int off_y, int px_w, int px_h) {
+    assert(image.bits_per_pixel == 1);
+    Matrix1BPP(image.data, image.width, image.height, off_x, off_y, px_w, px_h);
+}
+
+void Matrix8BPPHeightMap(const ImageView& image, int off_x, int off_y, int px_w, int px_h) {
+    assert(image.bits_per_pixel == 8);
+    for (int y = 0; y < image.height; ++y) {
+        Matrix8BPPHeightMap(image.Row(y), image.width, 1, off_x, off_y + y * px_h, px_w, px_h);
+    }
+}
+
+void Matrix8BPPPlayers(const ImageView& image, int off_x, int off_y, int px_w, int px_h) {
+    assert(image.bits_per_pixel == 8);
+    for (int y = 0; y < image.height; ++y) {
+        Matrix8BPPPlayers(image.Row(y), image.width, 1, off_x, off_y + y * px_h, px_w, px_h);
+    }
+}
+
+void ImageRGB(const ImageView& image, int off_x, int off_y) {
+    assert(renderer_);
+    assert(window_);
+    assert(image.bits_per_pixel == 24);
+
+    // SDL reads the pixels in place, the surface only describes them.
+    SDL_Surface* surface =
+        SDL_CreateRGBSurfaceWithFormatFrom(const_cast<char*>(image.data), image.width, image.height, 24, image.stride,
+                                           SDL_PixelFormatEnum::SDL_PIXELFORMAT_RGB24);
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer_, surface);
+    SDL_FreeSurface(surface);
+
+    SDL_Rect dstRect = CreateRect(off_x, off_y, image.width, image.height);
+    SDL_RenderCopy(renderer_, texture, nullptr, &dstRect);
+
+    SDL_DestroyTexture(texture);
+}
+
 void Render() {
     assert(renderer_);
     assert(window_);
@@ -1,5 +1,9 @@
 #pragma once
 
+namespace sc2 {
+struct ImageView;
+}  // namespace sc2
+
 namespace sc2::renderer {
 void Initialize(const char* title, int x, int y, int w, int h, unsigned int flags = 0);
 void Shutdown();
@@ -7,6 +11,11 @@ void Matrix1BPP(const char* bytes, int w_mat, int h_mat, int off_x, int off_y, i
 void Matrix8BPPHeightMap(const char* bytes, int w_mat, int h_mat, int off_x, int off_y, int px_w, int px_h);
 void Matrix8BPPPlayers(const char* bytes, int w_mat, int h_mat, int off_x, int off_y, int px_w, int px_h);
 void ImageRGB(const char* bytes, int width, int height, int off_x, int off_y);
+// Draw images straight from the responses they were received in, rows are read with the stride of the view.
+void Matrix1BPP(const ImageView& image, int off_x, int off_y, int px_w, int px_h);
+void Matrix8BPPHeightMap(const ImageView& image, int off_x, int off_y, int px_w, int px_h);
+void Matrix8BPPPlayers(const ImageView& image, int off_x, int off_y, int px_w, int px_h);
+void ImageRGB(const ImageView& image, int off_x, int off_y);
 void Render();
 
 }  // namespace sc2::renderer
@@ -0,0 +1,93 @@
+#include "sc2_thread_pool.h"
+
+#include <cassert>
+
+#include "sc2_trace.h"
+
+namespace sc2 {
+
+ThreadPool::ThreadPool(size_t thread_count)
+    : stopping_(false), task_(nullptr), task_count_(0), next_task_(0), running_tasks_(0) {
+    Reserve(thread_count);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        stopping_ = true;
+    }
+    work_available_.notify_all();
+
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Reserve(size_t thread_count) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    while (workers_.size() < thread_count) {
+        workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+size_t ThreadPool::Size() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return workers_.size();
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+
+    // The calling thread takes one of the tasks.
+    Reserve(count - 1);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    assert(!task_);
+    task_ = &task;
+    task_count_ = count;
+    next_task_ = 0;
+    running_tasks_ = 0;
+    work_available_.notify_all();
+
+    RunTasks(lock);
+
+    work_done_.wait(lock, [this] { return next_task_ == task_count_ && running_tasks_ == 0; });
+    task_ = nullptr;
+    task_count_ = 0;
+    next_task_ = 0;
+}
+
+void ThreadPool::WorkerLoop() {
+    SC2_TRACE_THREAD_NAME("ThreadPool worker");
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        work_available_.wait(lock, [this] { return stopping_ || next_task_ < task_count_; });
+        if (stopping_) {
+            return;
+        }
+
+        RunTasks(lock);
+    }
+}
+
+void ThreadPool::RunTasks(std::unique_lock<std::mutex>& lock) {
+    while (next_task_ < task_count_) {
+        const size_t index = next_task_++;
+        const std::function<void(size_t)>& task = *task_;
+        ++running_tasks_;
+
+        lock.unlock();
+        task(index);
+        lock.lock();
+
+        --running_tasks_;
+    }
+
+    if (running_tasks_ == 0) {
+        work_done_.notify_all();
+    }
+}
+
+}  // namespace sc2
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sc2 {
+
+// A set of worker threads that live as long as the pool and run batches of tasks. Batches are meant for tasks that
+// block on each other, like clients stepping the same multiplayer game, so every task of a batch is guaranteed its own
+// thread: the pool grows when a batch has more tasks than there are threads.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t thread_count = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Starts workers until there are at least thread_count of them, workers are never stopped before destruction.
+    void Reserve(size_t thread_count);
+    size_t Size() const;
+
+    // Runs task(0) .. task(count - 1) in parallel and returns once all of them have finished. The calling thread runs
+    // tasks too. Must not be called concurrently or from within a task.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& task);
+
+private:
+    void WorkerLoop();
+    // Runs tasks of the current batch until none is left to claim, the mutex must be held.
+    void RunTasks(std::unique_lock<std::mutex>& lock);
+
+    std::vector<std::thread> workers_;
+    mutable std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable work_done_;
+    bool stopping_;
+
+    // The current batch.
+    const std::function<void(size_t)>* task_;
+    size_t task_count_;
+    size_t next_task_;
+    size_t running_tasks_;
+};
+
+}  // namespace sc2
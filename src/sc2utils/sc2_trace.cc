@@ -0,0 +1,191 @@
+#include "sc2_trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sc2 {
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    int64_t id;
+    int64_t start_ns;
+    int64_t duration_ns;
+};
+
+// Events are appended to a list of fixed size chunks so that they never move. The owning thread is the only writer, it
+// publishes an event by bumping the size of its chunk and a new chunk by linking it, readers only ever see complete
+// events.
+struct TraceChunk {
+    static const size_t kCapacity = 4096;
+
+    TraceEvent events[kCapacity];
+    std::atomic<size_t> size{0};
+    std::atomic<TraceChunk*> next{nullptr};
+};
+
+struct TraceBuffer {
+    explicit TraceBuffer(uint32_t thread_id) : thread_id(thread_id), tail(&head) {
+    }
+
+    ~TraceBuffer() {
+        TraceChunk* chunk = head.next.load();
+        while (chunk) {
+            TraceChunk* next = chunk->next.load();
+            delete chunk;
+            chunk = next;
+        }
+    }
+
+    void Append(const TraceEvent& event) {
+        size_t size = tail->size.load(std::memory_order_relaxed);
+        if (size == TraceChunk::kCapacity) {
+            TraceChunk* chunk = new TraceChunk();
+            tail->next.store(chunk, std::memory_order_release);
+            tail = chunk;
+            size = 0;
+        }
+
+        tail->events[size] = event;
+        tail->size.store(size + 1, std::memory_order_release);
+    }
+
+    const uint32_t thread_id;
+    std::string thread_name;  // Guarded by the registry mutex.
+    TraceChunk head;
+    TraceChunk* tail;  // Only touched by the owning thread.
+};
+
+// Buffers outlive their threads, threads of a pool may be gone by the time the trace is written.
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+    std::atomic_bool tracing{false};
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+TraceRegistry& GetRegistry() {
+    // Never destroyed, threads may still record while static objects are destroyed at exit.
+    static TraceRegistry* registry = new TraceRegistry();
+    return *registry;
+}
+
+TraceBuffer& GetThreadBuffer() {
+    thread_local TraceBuffer* buffer = nullptr;
+    if (!buffer) {
+        TraceRegistry& registry = GetRegistry();
+        std::lock_guard<std::mutex> guard(registry.mutex);
+        registry.buffers.push_back(std::make_unique<TraceBuffer>(static_cast<uint32_t>(registry.buffers.size() + 1)));
+        buffer = registry.buffers.back().get();
+    }
+
+    return *buffer;
+}
+
+int64_t GetTraceTime() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                GetRegistry().epoch)
+        .count();
+}
+
+// Chrome traces are in microseconds, keep the nanoseconds as decimals.
+std::string FormatMicroseconds(int64_t ns) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%lld.%03lld", static_cast<long long>(ns / 1000),
+                  static_cast<long long>(ns % 1000));
+    return buffer;
+}
+
+void WriteEscaped(std::ofstream& file, const std::string& value) {
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            file << '\\';
+        }
+        file << c;
+    }
+}
+
+}  // namespace
+
+TraceScope::TraceScope(const char* name, int64_t id) : name_(nullptr), id_(id), start_ns_(0) {
+    if (IsTracing()) {
+        name_ = name;
+        start_ns_ = GetTraceTime();
+    }
+}
+
+TraceScope::~TraceScope() {
+    if (!name_) {
+        return;
+    }
+
+    GetThreadBuffer().Append({name_, id_, start_ns_, GetTraceTime() - start_ns_});
+}
+
+void StartTracing() {
+    GetRegistry().tracing = true;
+}
+
+void StopTracing() {
+    GetRegistry().tracing = false;
+}
+
+bool IsTracing() {
+    return GetRegistry().tracing.load(std::memory_order_relaxed);
+}
+
+void SetTraceThreadName(const std::string& name) {
+    TraceBuffer& buffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> guard(GetRegistry().mutex);
+    buffer.thread_name = name;
+}
+
+bool WriteTrace(const std::string& path) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+
+    TraceRegistry& registry = GetRegistry();
+    std::lock_guard<std::mutex> guard(registry.mutex);
+
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    for (const std::unique_ptr<TraceBuffer>& buffer : registry.buffers) {
+        file << (first ? "\n" : ",\n");
+        file << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->thread_id
+             << ", \"args\": {\"name\": \"";
+        if (buffer->thread_name.empty()) {
+            file << "Thread " << buffer->thread_id;
+        } else {
+            WriteEscaped(file, buffer->thread_name);
+        }
+        file << "\"}}";
+        first = false;
+
+        for (const TraceChunk* chunk = &buffer->head; chunk; chunk = chunk->next.load(std::memory_order_acquire)) {
+            const size_t size = chunk->size.load(std::memory_order_acquire);
+            for (size_t i = 0; i < size; ++i) {
+                const TraceEvent& event = chunk->events[i];
+                file << ",\n{\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+                     << buffer->thread_id << ", \"ts\": " << FormatMicroseconds(event.start_ns)
+                     << ", \"dur\": " << FormatMicroseconds(event.duration_ns);
+                if (event.id >= 0) {
+                    file << ", \"args\": {\"id\": " << event.id << "}";
+                }
+                file << "}";
+            }
+        }
+    }
+
+    file << (first ? "" : "\n") << "]}\n";
+    return static_cast<bool>(file);
+}
+
+}  // namespace sc2
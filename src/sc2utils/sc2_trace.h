@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Timeline of where the client spends its time, written in the Chrome trace event format so that it can be opened in
+// Perfetto or chrome://tracing. Spans are recorded with SC2_TRACE_SCOPE, which compiles to nothing unless the project
+// is configured with -DSC2_TRACING=ON. Even then nothing is recorded until StartTracing is called.
+//
+// Every thread records into a buffer of its own, appending a span takes no lock and doesn't wait on other threads.
+
+namespace sc2 {
+
+// Records a span from its construction to its destruction on the calling thread, if tracing.
+class TraceScope {
+public:
+    // The name must outlive the trace, e.g. a string literal. The id is written along with the span if not negative,
+    // e.g. to tell apart the clients stepped on a thread.
+    explicit TraceScope(const char* name, int64_t id = -1);
+    ~TraceScope();
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+    int64_t id_;
+    int64_t start_ns_;
+};
+
+// Starts or stops recording spans. Spans recorded so far are kept.
+void StartTracing();
+void StopTracing();
+bool IsTracing();
+
+// Names the calling thread in the trace, threads are named after the order they first recorded a span otherwise.
+void SetTraceThreadName(const std::string& name);
+
+// Writes the spans recorded so far by all threads as a Chrome trace JSON file. Threads may keep recording meanwhile.
+bool WriteTrace(const std::string& path);
+
+}  // namespace sc2
+
+#define SC2_TRACE_CONCAT_IMPL(a, b) a##b
+#define SC2_TRACE_CONCAT(a, b) SC2_TRACE_CONCAT_IMPL(a, b)
+
+#if defined(SC2_TRACING)
+#define SC2_TRACE_SCOPE(name) ::sc2::TraceScope SC2_TRACE_CONCAT(sc2_trace_scope_, __LINE__)(name)
+#define SC2_TRACE_SCOPE_ID(name, id) ::sc2::TraceScope SC2_TRACE_CONCAT(sc2_trace_scope_, __LINE__)(name, id)
+#define SC2_TRACE_THREAD_NAME(name) ::sc2::SetTraceThreadName(name)
+#else
+#define SC2_TRACE_SCOPE(name) ((void)0)
+#define SC2_TRACE_SCOPE_ID(name, id) ((void)0)
+#define SC2_TRACE_THREAD_NAME(name) ((void)0)
+#endif
@@ -18,6 +18,7 @@
 // Tests. Easier to extern than create a .h for a single function prototype.
 namespace sc2 {
 bool TestAbilityRemap(int argc, char** argv);
+bool TestGeometryKernels(int argc, char** argv);
 }
 
 #define TEST(X)                                                    \
@@ -34,6 +35,7 @@ int main(int argc, char* argv[]) {
     bool success = true;
 
     // Add tests here.
+    TEST(sc2::TestGeometryKernels);
     TEST(sc2::TestAbilityRemap);
     TEST(sc2::TestSnapshots);
     TEST(sc2::TestMultiplayer);
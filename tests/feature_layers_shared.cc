@@ -50,11 +50,10 @@ const char* GetPlayerRelativeLayer(Agent* agent, FeatureLayerType type, FeatureL
     if (bitsPerPixel != 8)
         return "bits_per_pixel of player_relative incorrect size";
 
-    const std::string& data = image->data();
-    if (data.size() != layer.width * layer.height)
+    layer.image = agent->Observation()->GetImageView(*image);
+    if (!layer.image.IsValid())
         return "Feature layer data incorrect size";
 
-    layer.data = data;
     return nullptr;
 }
 
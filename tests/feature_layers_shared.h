@@ -1,7 +1,6 @@
 #pragma once
 
 #include <cassert>
-#include <string>
 
 #include "sc2api/sc2_common.h"
 #include "sc2api/sc2_map_info.h"
@@ -16,12 +15,13 @@ struct FeatureLayer8BPP {
 
     char Read(const Point2DI& pos) {
         assert(InBounds(pos));
-        return data[pos.x + pos.y * width];
+        return image.Row(pos.y)[pos.x];
     }
 
     int width;
     int height;
-    std::string data;
+    // References the observation the layer was taken from and keeps it alive.
+    ImageView image;
 };
 
 Point2DI ConvertWorldToCamera(const GameInfo& game_info, const Point2D camera_world, const Point2D& world);
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "sc2api/sc2_common.h"
+
+namespace sc2 {
+
+//
+// The batch geometry functions must give exactly the results of the single point functions, whatever the instruction
+// set they run with. Counts that aren't a multiple of the vector width exercise the scalar tails of the kernels.
+//
+
+namespace {
+
+const size_t kMaxCount = 67;
+
+class GeometryChecker {
+public:
+    explicit GeometryChecker(const std::string& level_name) : level_name_(level_name), errors_(0) {
+    }
+
+    void Check(bool condition, const std::string& function, size_t count) {
+        if (!condition) {
+            std::cerr << function << " differs from the single point functions with " << count << " points ("
+                      << level_name_ << ")." << std::endl;
+            ++errors_;
+        }
+    }
+
+    bool Succeeded() const {
+        return errors_ == 0;
+    }
+
+private:
+    std::string level_name_;
+    int errors_;
+};
+
+std::vector<Point2D> CreatePoints(size_t count, std::mt19937& generator) {
+    std::uniform_real_distribution<float> position(-50.0F, 250.0F);
+    std::vector<Point2D> points;
+    for (size_t i = 0; i < count; ++i) {
+        points.emplace_back(position(generator), position(generator));
+    }
+
+    // Equally distant points, the first one must be reported as the closest.
+    if (count > 12) {
+        points[count - 1] = points[3];
+        points[9] = points[3];
+    }
+
+    return points;
+}
+
+void CheckPoints(const std::vector<Point2D>& points, const Point2D& center, GeometryChecker& checker) {
+    const size_t count = points.size();
+    std::vector<float> xs;
+    std::vector<float> ys;
+    for (const Point2D& point : points) {
+        xs.push_back(point.x);
+        ys.push_back(point.y);
+    }
+
+    std::vector<float> expected_distances;
+    std::vector<float> expected_squared;
+    std::vector<size_t> expected_in_radius;
+    size_t expected_closest = count;
+    float expected_closest_distance = 0.0F;
+    const float radius = 60.0F;
+    for (size_t i = 0; i < count; ++i) {
+        expected_distances.push_back(Distance2D(center, points[i]));
+        expected_squared.push_back(DistanceSquared2D(center, points[i]));
+        if (expected_squared[i] <= radius * radius) {
+            expected_in_radius.push_back(i);
+        }
+        if (expected_closest == count || expected_squared[i] < expected_closest_distance) {
+            expected_closest = i;
+            expected_closest_distance = expected_squared[i];
+        }
+    }
+
+    std::vector<float> distances(count);
+    Distances2D(center, points.data(), count, distances.data());
+    checker.Check(distances == expected_distances, "Distances2D", count);
+    Distances2D(center, xs.data(), ys.data(), count, distances.data());
+    checker.Check(distances == expected_distances, "Distances2D of coordinates", count);
+
+    DistancesSquared2D(center, points.data(), count, distances.data());
+    checker.Check(distances == expected_squared, "DistancesSquared2D", count);
+    DistancesSquared2D(center, xs.data(), ys.data(), count, distances.data());
+    checker.Check(distances == expected_squared, "DistancesSquared2D of coordinates", count);
+
+    float closest_distance = -1.0F;
+    size_t closest = ClosestPoint2D(center, points.data(), count, &closest_distance);
+    checker.Check(closest == expected_closest && (count == 0 || closest_distance == expected_closest_distance),
+                  "ClosestPoint2D", count);
+    closest = ClosestPoint2D(center, xs.data(), ys.data(), count, &closest_distance);
+    checker.Check(closest == expected_closest && (count == 0 || closest_distance == expected_closest_distance),
+                  "ClosestPoint2D of coordinates", count);
+
+    std::vector<size_t> in_radius;
+    PointsInRadius2D(center, radius, points.data(), count, in_radius);
+    checker.Check(in_radius == expected_in_radius, "PointsInRadius2D", count);
+    in_radius.clear();
+    PointsInRadius2D(center, radius, xs.data(), ys.data(), count, in_radius);
+    checker.Check(in_radius == expected_in_radius, "PointsInRadius2D of coordinates", count);
+
+    const size_t rows = std::min(count, count % 5 + 1);
+    std::vector<float> matrix(rows * count);
+    DistanceMatrix2D(points.data(), rows, points.data(), count, matrix.data());
+    bool matrix_matches = true;
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < count; ++j) {
+            matrix_matches = matrix_matches && matrix[i * count + j] == Distance2D(points[i], points[j]);
+        }
+    }
+    checker.Check(matrix_matches, "DistanceMatrix2D", count);
+}
+
+}  // namespace
+
+bool TestGeometryKernels(int, char**) {
+    const SimdLevel default_level = GetSimdLevel();
+    const SimdLevel levels[] = {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2};
+    const char* level_names[] = {"scalar", "SSE2", "AVX2"};
+
+    // The centroids of the scalar functions, the vectorized ones must find the same to the bit.
+    std::vector<Point2D> expected_centroids;
+
+    bool success = true;
+    for (size_t level = 0; level < 3; ++level) {
+        if (SetSimdLevel(levels[level]) != levels[level]) {
+            std::cout << "Skipping " << level_names[level] << ", the processor doesn't support it." << std::endl;
+            continue;
+        }
+
+        GeometryChecker checker(level_names[level]);
+        std::mt19937 generator(1);
+        for (size_t count = 0; count <= kMaxCount; ++count) {
+            const std::vector<Point2D> points = CreatePoints(count, generator);
+            CheckPoints(points, Point2D(100.0F, 80.0F), checker);
+
+            std::vector<float> xs;
+            std::vector<float> ys;
+            for (const Point2D& point : points) {
+                xs.push_back(point.x);
+                ys.push_back(point.y);
+            }
+
+            const Point2D centroid = Centroid2D(points.data(), count);
+            checker.Check(centroid == Centroid2D(xs.data(), ys.data(), count), "Centroid2D of coordinates", count);
+            if (levels[level] == SimdLevel::Scalar) {
+                Point2D mean;
+                for (const Point2D& point : points) {
+                    mean += point / static_cast<float>(count);
+                }
+                checker.Check(Distance2D(centroid, mean) < 0.01F, "Centroid2D", count);
+                expected_centroids.push_back(centroid);
+            } else {
+                checker.Check(centroid == expected_centroids[count], "Centroid2D", count);
+            }
+        }
+
+        success = checker.Succeeded() && success;
+    }
+
+    SetSimdLevel(default_level);
+    return success;
+}
+
+}  // namespace sc2
@@ -4,9 +4,11 @@
 #include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 
 #include "bot_examples.h"
 #include "sc2api/sc2_api.h"
+#include "sc2api/sc2_unit_filters.h"
 #include "test_framework.h"
 
 using namespace std::chrono;
@@ -18,6 +20,8 @@ struct EndOfTestsStats {
     std::vector<int> structure_count_;
     std::vector<double> avg_ping_;
     std::vector<double> avg_observation_;
+    std::vector<size_t> filtered_unit_count_;
+    std::vector<double> avg_unit_filter_;
     bool reset_;
 
     void Reset() {
@@ -25,6 +29,8 @@ struct EndOfTestsStats {
         structure_count_.clear();
         avg_ping_.clear();
         avg_observation_.clear();
+        filtered_unit_count_.clear();
+        avg_unit_filter_.clear();
         reset_ = true;
     }
 };
@@ -50,6 +56,22 @@ duration<double> TimedObservation(ControlInterface* control, int observation_cou
     return duration_cast<duration<double>>(high_resolution_clock::now() - start);
 }
 
+duration<double> TimedUnitFilter(const ObservationInterface* observation, int filter_count) {
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+    size_t matched = 0;
+    for (int i = 0; i < filter_count; ++i) {
+        matched += observation->GetUnits(Unit::Alliance::Self, IsUnit(UNIT_TYPEID::TERRAN_MARINE)).size();
+        matched += observation->GetUnits([](const Unit& unit) { return unit.health < unit.health_max; }).size();
+    }
+    duration<double> time = duration_cast<duration<double>>(high_resolution_clock::now() - start);
+
+    // Keep the queries from being optimized away.
+    if (matched == std::numeric_limits<size_t>::max()) {
+        std::cout << matched << std::endl;
+    }
+    return time;
+}
+
 class PingBot : public TestSequence {
 public:
     void OnStep() final;
@@ -77,6 +99,21 @@ private:
     double sum_observation_time_ = 0;
 };
 
+// Mirrors the typical bot workload of filtering several hundred observed units many times per step.
+class UnitFilterBot : public TestSequence {
+public:
+    void OnStep() final;
+
+    static const int FILTER_COUNT = 100;
+
+private:
+    void OnTestStart() final;
+    void OnTestFinish() final;
+
+    int step_count_ = 0;
+    double sum_filter_time_ = 0;
+};
+
 void PingBot::OnStep() {
     duration<double> time = TimedPing(agent_->Control(), PING_COUNT);
     double ping_avg = (time.count() / PING_COUNT) * 1000;
@@ -157,6 +194,74 @@ void FeatureLayerBot::OnTestFinish() {
     GetStats().avg_observation_.push_back(avg_obs);
 }
 
+void UnitFilterBot::OnStep() {
+    duration<double> time = TimedUnitFilter(agent_->Observation(), FILTER_COUNT);
+
+    sum_filter_time_ += time.count() * 1000;
+    ++step_count_;
+}
+
+void UnitFilterBot::OnTestStart() {
+    wait_game_loops_ = 100;
+
+    static const int MARINE_COUNT = 300;
+    static const int ZERGLING_COUNT = 300;
+
+    DebugInterface* debug = agent_->Debug();
+    debug->DebugCreateUnit(UNIT_TYPEID::TERRAN_MARINE, GetMapCenter(), agent_->Observation()->GetPlayerID(),
+                           MARINE_COUNT);
+    debug->DebugCreateUnit(UNIT_TYPEID::ZERG_ZERGLING, GetMapCenter(), agent_->Observation()->GetPlayerID(),
+                           ZERGLING_COUNT);
+    debug->SendDebug();
+}
+
+void UnitFilterBot::OnTestFinish() {
+    EndOfTestsStats& stats = GetStats();
+    stats.filtered_unit_count_.push_back(agent_->Observation()->GetUnits().size());
+    // No average without a step, e.g. if the game ended before the units spawned.
+    stats.avg_unit_filter_.push_back(step_count_ > 0 ? sum_filter_time_ / step_count_ : 0.0);
+}
+
+// Steps an empty game as fast as possible, the time is spent almost entirely in the round trips to the game.
+class StepRateBot : public Agent {
+public:
+    static const int STEP_COUNT = 2000;
+
+    void OnGameStart() final {
+        step_count_ = 0;
+        start_ = high_resolution_clock::now();
+    }
+
+    void OnStep() final {
+        if (++step_count_ != STEP_COUNT) {
+            return;
+        }
+
+        steps_per_second_ =
+            STEP_COUNT / duration_cast<duration<double>>(high_resolution_clock::now() - start_).count();
+        Debug()->DebugEndGame(true);
+        Debug()->SendDebug();
+    }
+
+    void OnGameEnd() final {
+        finished_ = true;
+    }
+
+    bool IsFinished() const {
+        return finished_;
+    }
+
+    double GetStepsPerSecond() const {
+        return steps_per_second_;
+    }
+
+private:
+    int step_count_ = 0;
+    bool finished_ = false;
+    double steps_per_second_ = 0.0;
+    high_resolution_clock::time_point start_;
+};
+
 class PerformanceTests : public UnitTestBot {
 public:
     PerformanceTests(int feature_layer_width, int feature_layer_height);
@@ -182,6 +287,8 @@ PerformanceTests::PerformanceTests(int feature_layer_width, int feature_layer_he
         Add(PingBot());
         Add(FeatureLayerBot());
     }
+
+    Add(UnitFilterBot());
 }
 
 void PerformanceTests::PreGamePing() {
@@ -210,6 +317,18 @@ void PerformanceTests::OnTestsEnd() {
     }
     std::cout << "-------------------------------------------------------" << std::endl;
 
+    std::cout << std::endl;
+
+    std::cout << "Unit filters (2 x " << UnitFilterBot::FILTER_COUNT << " GetUnits calls per step)" << std::endl;
+    std::cout << "-------------------------------------" << std::endl;
+    std::cout << "|" << std::setw(10) << std::left << "Units" << std::right << "|" << std::setw(24) << std::left
+              << "Filters per step (ms)" << std::right << "|" << std::endl;
+    for (size_t i = 0; i < stats.avg_unit_filter_.size(); ++i) {
+        std::cout << "|" << std::setw(10) << std::left << stats.filtered_unit_count_[i] << std::right << "|"
+                  << std::setw(24) << std::left << stats.avg_unit_filter_[i] << std::right << "|" << std::endl;
+    }
+    std::cout << "-------------------------------------" << std::endl;
+
     std::cout << std::endl << std::endl;
 }
 
@@ -242,11 +361,51 @@ void TestPerformance(int argc, char** argv, int feature_layer_width, int feature
     }
 }
 
+double TestStepRate(int argc, char** argv, bool step_and_observe) {
+    sc2::Coordinator coordinator;
+    if (!coordinator.LoadSettings(argc, argv)) {
+        return 0.0;
+    }
+
+    StepRateBot bot;
+    coordinator.SetStepAndObserve(step_and_observe);
+    coordinator.SetParticipants({CreateParticipant(Race::Terran, &bot)});
+
+    coordinator.LaunchStarcraft();
+    coordinator.StartGame(sc2::kMapEmpty);
+
+    while (!bot.IsFinished()) {
+        if (!coordinator.Update()) {
+            break;
+        }
+    }
+
+    return bot.GetStepsPerSecond();
+}
+
+void TestStepRate(int argc, char** argv) {
+    const double separate = TestStepRate(argc, argv, false);
+    const double fused = TestStepRate(argc, argv, true);
+
+    std::cout << std::endl;
+    std::cout << "Step rate (" << StepRateBot::STEP_COUNT << " steps of 1 game loop)" << std::endl;
+    std::cout << "-------------------------------------" << std::endl;
+    std::cout << "|" << std::setw(24) << std::left << "Mode" << std::right << "|" << std::setw(10) << std::left
+              << "Steps/s" << std::right << "|" << std::endl;
+    std::cout << "|" << std::setw(24) << std::left << "Step, then observation" << std::right << "|" << std::setw(10)
+              << std::left << separate << std::right << "|" << std::endl;
+    std::cout << "|" << std::setw(24) << std::left << "StepAndObserve" << std::right << "|" << std::setw(10)
+              << std::left << fused << std::right << "|" << std::endl;
+    std::cout << "-------------------------------------" << std::endl;
+    std::cout << std::endl;
+}
+
 bool TestPerformance(int argc, char** argv) {
     TestPerformance(argc, argv, 32, 32);
     TestPerformance(argc, argv, 64, 64);
     TestPerformance(argc, argv, 128, 128);
     TestPerformance(argc, argv, 256, 256);
+    TestStepRate(argc, argv);
     return true;
 }
 